@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The results of the hardware calibration that do not change between runs on the same machine: the REF threshold of the
+// RefreshTimer, the bank conflict threshold and the number of ACTs per tREFI. They are stored in a text file together
+// with the CPU model and the installed DIMMs, so that later runs on the same machine can skip the calibration; a stored
+// profile is only used if both still match.
+class CalibrationProfile {
+public:
+  static constexpr const char *DEFAULT_PATH = "calibration.profile";
+  // the CPU model or DIMM id if it cannot be read
+  static constexpr const char *UNKNOWN = "unknown";
+
+  std::string cpu_model;
+  std::string dimm_id;
+  // the raw threshold of the RefreshTimer (see RefreshTimer::get_raw_refresh_threshold)
+  uint64_t refresh_threshold = 0;
+  uint64_t cycles_per_refresh = 0;
+  uint64_t bank_conflict_threshold = 0;
+  uint64_t acts_per_trefi = 0;
+  // the ACTs per tREFI of each bank (of mapping 0) while the given number of threads, placed with the given policy (see
+  // to_string(PLACEMENT_POLICY)), hammer different banks at once; only measured on demand (see
+  // HammerSuite::measure_act_budget)
+  std::map<std::pair<size_t, std::string>, std::vector<uint64_t>> bank_acts_per_trefi;
+
+  // where the profile is stored, empty if it is not persisted
+  std::string path;
+
+  /// the CPU model as reported by /proc/cpuinfo
+  static std::string read_cpu_model();
+
+  /// manufacturer, part and serial number of every populated DIMM slot as reported by the SMBIOS memory device entries
+  static std::string read_dimm_id();
+
+  /// loads the profile stored at path if it belongs to this machine, measures (and stores) a new one otherwise
+  static CalibrationProfile load_or_measure(const std::string &path, volatile char *start, bool recalibrate);
+
+  /// runs the full calibration on the memory at start
+  static CalibrationProfile measure(volatile char *start);
+
+  /// reads the profile stored at path, returns false if there is none or it is incomplete
+  static bool load(const std::string &path, CalibrationProfile &profile);
+
+  void save() const;
+
+  /// whether this profile was measured on the same CPU model and DIMMs as other, never if they are unknown
+  [[nodiscard]] bool same_machine(const CalibrationProfile &other) const;
+};
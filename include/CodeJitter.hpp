@@ -6,11 +6,14 @@
 #ifndef CODEJITTER
 #define CODEJITTER
 
+#include <memory>
 #include <vector>
 
 #include "FuzzingParameterSet.hpp"
 #include "DRAMAddr.hpp"
 #include "Enums.hpp"
+#include "JitCache.hpp"
+#include "PatternIR.hpp"
 #include "asmjit/core/jitruntime.h"
 #include "asmjit/core/logger.h"
 #include "asmjit/x86/x86assembler.h"
@@ -39,13 +42,66 @@ struct HammeringData {
 
 class CodeJitter {
  private:
-  /// runtime for JIT code execution, can be reused by cleaning the function ptr (see cleanup method)
-  asmjit::JitRuntime runtime;
+  /// runtime for JIT code execution, borrowed from the JitRuntimePool on the first jit call and returned to the pool
+  /// by cleanup()
+  asmjit::JitRuntime *runtime = nullptr;
 
-  /// a logger that keeps track of the generated ASM instructions - useful for debugging
+  /// a logger that keeps track of the generated ASM instructions - useful for debugging, only created if
+  /// log_assembly is set
   asmjit::StringLogger *logger = nullptr;
 
+  /// borrows a runtime from the pool if this instance does not hold one yet
+  asmjit::JitRuntime &get_runtime();
+
+  /// (offset in the function, address) of each address immediate emitted by emit_address
+  using AddressImmediates = std::vector<std::pair<size_t, uint64_t>>;
+
+  /// the relocatable function (see relocatable), stored in pages owned by this instance
+  uint8_t *reloc_code = nullptr;
+  size_t reloc_size = 0;
+  AddressImmediates reloc_immediates;
+  PatternIR reloc_loop;
+  FLUSHING_STRATEGY reloc_flushing;
+  FENCING_STRATEGY reloc_fencing;
+  FENCE_TYPE reloc_fence_type;
+  int reloc_total_activations = 0;
+  uint64_t reloc_sync_ref_threshold = 0;
+  SYNC_MODE reloc_sync_mode = SYNC_MODE::PROBE;
+  size_t reloc_code_size = 0;
+
+  /// the size of the machine code of fn in bytes
+  size_t code_size = 0;
+
+  /// lowers the loop body (see PatternIR::make_loop) into a hammering function; if immediates is given, the position
+  /// of every address immediate is recorded in it
+  void assemble_hammer_fn(asmjit::CodeHolder &code,
+                          const PatternIR &loop,
+                          FENCE_TYPE fence_type,
+                          int total_num_activations,
+                          AddressImmediates *immediates);
+
+  /// jit_strict for relocatable instances: patches the existing function if possible, otherwise assembles a new one
+  void jit_relocatable(FLUSHING_STRATEGY flushing,
+                       FENCING_STRATEGY fencing,
+                       const PatternIR &pattern,
+                       FENCE_TYPE fence_type,
+                       int total_num_activations);
+
+  /// patches the address immediates of the relocatable function to hammer the given loop body instead; returns false
+  /// (without modifying the function) if the new loop would not result in the same instructions
+  bool relocate(const PatternIR &loop);
+
+  /// frees the relocatable function
+  void release_relocatable();
+
+  /// loads addr into %rax
+  static void emit_address(asmjit::x86::Assembler &assembler, uint64_t addr, AddressImmediates *immediates);
+
   int (*fn)(HammeringData*) = nullptr;
+
+  /// the JitCache entry fn belongs to and its key; cached functions are shared and must not be released by this instance
+  std::shared_ptr<JitCacheEntry> cached_fn;
+  JitCacheKey cached_key;
   size_t (*fn_ref_sync)(RefSyncData*) = nullptr;
 
  public:
@@ -59,23 +115,51 @@ class CodeJitter {
 
   int num_aggs_for_sync;
 
+  /// the emitter used by jit_strict for the aggressor accesses
+  JIT_EMITTER emitter = JIT_EMITTER::UNROLLED;
+
+  /// how jit_strict synchronizes with REF; SYNC_MODE::PREDICTED requires a running RefPhaseTracker
+  SYNC_MODE sync_mode = SYNC_MODE::PROBE;
+
+  /// whether the generated ASM instructions should be recorded in a StringLogger (debugging only)
+  bool log_assembly = false;
+
+  /// if set, jit_strict keeps the generated function across hammer runs and, when the same pattern is moved to
+  /// another location, only patches the address immediates instead of re-assembling it. The function is only
+  /// released by cleanup() once relocatable is reset.
+  bool relocatable = false;
+
+  /// the number of functions assembled and relocated in relocatable mode
+  size_t num_assemblies = 0;
+  size_t num_relocations = 0;
+
   /// constructor
   CodeJitter();
   
   /// destructor
   ~CodeJitter();
 
-  /// generates the jitted function and assigns the function pointer fn to it
+  // the jitted functions belong to the borrowed runtime, hence instances must not be copied
+  CodeJitter(const CodeJitter &) = delete;
+  CodeJitter &operator=(const CodeJitter &) = delete;
+
+  /// generates the jitted function and assigns the function pointer fn to it; identical functions are only generated
+  /// once and afterwards taken from the JitCache
   void jit_strict(
     FLUSHING_STRATEGY flushing,
     FENCING_STRATEGY fencing,
-    const std::vector<volatile char *> &aggressor_pairs,
+    const PatternIR &pattern,
     FENCE_TYPE fence_type,
     int total_num_activations
   );
 
-  /// does the hammering if the function was previously created successfully, otherwise does nothing
-  int hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool verbose, bool print_act_data = false);
+  /// does the hammering if the function was previously created successfully, otherwise does nothing; the ACT count and
+  /// duration of the hammering loop are stored in hammering_data if given
+  int hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool verbose, bool print_act_data = false,
+                     HammeringData *hammering_data = nullptr);
+
+  /// the size of the last jitted hammering function in bytes
+  [[nodiscard]] size_t get_code_size() const { return code_size; }
 
   /// cleans this instance associated function pointer that points to the function that was jitted at runtime;
   /// cleaning up is required to release memory before jit_strict can be called again
@@ -97,7 +181,16 @@ class CodeJitter {
   }
 
   static void sync_ref(const std::vector<volatile char *> &aggressor_pairs, asmjit::x86::Assembler &assembler);
-  static void sync_ref_nonrepeating(DRAMAddr initial_aggressor, size_t sync_ref_threshold, asmjit::x86::Assembler &assembler);
+  static void sync_ref_nonrepeating(DRAMAddr initial_aggressor, size_t sync_ref_threshold, asmjit::x86::Assembler &assembler,
+                                    AddressImmediates *immediates = nullptr);
+
+  /// waits until the next REF edge predicted by the RefPhaseTracker (extrapolated by whole periods if the published
+  /// edge already passed) without accessing any rows; falls back to sync_ref_nonrepeating while there is no prediction
+  static void sync_ref_predicted(DRAMAddr fallback_aggressor, size_t sync_ref_threshold, asmjit::x86::Assembler &assembler,
+                                 AddressImmediates *immediates = nullptr);
+
+  /// the rows accessed by sync_ref_nonrepeating for the given initial aggressor
+  static std::vector<volatile char *> sync_ref_addresses(DRAMAddr initial_aggressor);
 
   static constexpr size_t SYNC_REF_NUM_AGGRS = 128;
 };
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// A keyed, counter-based generator for the data pattern written to the allocation.
+// In contrast to srand()/rand(), the value of each 4-byte word is a pure function of (seed, byte offset), so any
+// range of memory can be regenerated independently, in any order and from any number of threads.
+class CounterRng {
+private:
+  uint32_t key_lo;
+  uint32_t key_hi;
+
+  // lowbias32 integer hash (Chris Wellons), used as the round function.
+  static inline uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+  }
+
+  // the key for all words whose index shares the given upper 32 bits
+  [[nodiscard]] uint32_t segment_key(uint32_t idx_hi) const {
+    return key_lo ^ mix(idx_hi ^ key_hi);
+  }
+
+public:
+  explicit CounterRng(uint64_t seed = 0);
+
+  void set_seed(uint64_t seed);
+
+  /// returns the expected value of the 4-byte word at the given byte offset.
+  [[nodiscard]] uint32_t word_at(uint64_t offset) const {
+    uint64_t idx = offset / sizeof(uint32_t);
+    return mix(mix((uint32_t)idx + segment_key((uint32_t)(idx >> 32))) ^ key_hi);
+  }
+
+  /// writes the expected values of nwords consecutive words, starting at the given byte offset, to dst.
+  void fill(uint32_t *dst, uint64_t offset, size_t nwords) const;
+
+  /// compares nwords consecutive words at mem with their expected values (starting at the given byte offset) without
+  /// materializing the expected values in memory; returns true if all words match.
+  [[nodiscard]] bool matches(const volatile void *mem, uint64_t offset, size_t nwords) const;
+
+  /// the name of the generation kernel selected at compile time.
+  static const char *kernel_name();
+};
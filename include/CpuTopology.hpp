@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Enums.hpp"
+
+struct CpuInfo {
+  int cpu;
+  int package;
+  int core;
+  // the lowest CPU sharing the L3 cache with this one (i.e., identifies the CCX on AMD)
+  int llc;
+  int node;
+  // the index of this hardware thread among the SMT siblings of its core
+  int smt_index;
+};
+
+// The CPU topology as reported by /sys/devices/system/cpu, used to place the hammering threads.
+class CpuTopology {
+private:
+  std::vector<CpuInfo> cpus;
+
+  CpuTopology();
+
+  // the hardware threads of all physical cores; the cores are ordered by package, LLC and core id, the threads of a
+  // core by their SMT index
+  [[nodiscard]] std::vector<std::vector<int>> physical_cores() const;
+
+public:
+  static CpuTopology &get();
+
+  [[nodiscard]] const std::vector<CpuInfo> &get_cpus() const { return cpus; }
+
+  [[nodiscard]] size_t num_physical_cores() const;
+  [[nodiscard]] size_t num_llcs() const;
+  [[nodiscard]] size_t num_nodes() const;
+  /// the ids of all NUMA nodes with online CPUs
+  [[nodiscard]] std::vector<int> get_nodes() const;
+
+  /// the CPUs for num_threads hammering threads according to the given policy, skipping the first `offset` physical
+  /// cores (or CPUs for PLACEMENT_POLICY::LEGACY)
+  [[nodiscard]] std::vector<int> place(PLACEMENT_POLICY policy, size_t num_threads, size_t offset) const;
+
+  /// a CPU on a physical core that is not used by any of the given CPUs (preferably on the same NUMA node as the
+  /// first of them), or the last CPU if all cores are in use
+  [[nodiscard]] int helper_cpu(const std::vector<int> &used) const;
+
+  [[nodiscard]] std::string to_string() const;
+};
@@ -2,12 +2,16 @@
 #include "BitFlip.hpp"
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 class CsvExporter {
 private:
   std::string path;
   FILE *logfile;
+  void write_flip(BitFlip &flip, uint64_t phys_addr, int run, int location, int pattern, int n_patterns, int n_aggs, int n_accesses, std::chrono::duration<float_t> duration);
 public:
   void export_flip(BitFlip &flip, int run, int location, int pattern, int n_patterns, int n_aggs, int n_accesses, std::chrono::duration<float_t> duration);
+  void export_flips(std::vector<BitFlip> &flips, int run, int location, int pattern, int n_patterns, int n_aggs, int n_accesses, std::chrono::duration<float_t> duration);
   CsvExporter(std::string filepath);
   ~CsvExporter();
 };
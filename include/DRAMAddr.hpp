@@ -39,6 +39,10 @@ class DRAMAddr {
   DRAMAddr() = default;
 
   static void initialize_mapping(int mapping_id, volatile char *start_address);
+  // the number of mappings initialized by initialize_mapping()
+  static size_t num_mappings();
+  // translation[bank] is the bank in to_mapping_id that corresponds to bank in from_mapping_id (the inverse translation
+  // is registered as well)
   static void initialize_bank_translation(int from_mapping_id, int to_mapping_id, std::vector<size_t> translation);
   static size_t translate_bank(int from_mapping_id, int to_mapping_id, size_t bank);
 
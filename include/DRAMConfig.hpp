@@ -6,10 +6,15 @@
 #ifndef BLACKSMITH_DRAMCONFIG_HPP_
 #define BLACKSMITH_DRAMCONFIG_HPP_
 
+#include <array>
+#include <atomic>
 #include <cstdlib>
 #include <cstdint>
 #include <string>
 #include <vector>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 // NOTE: Also update the to_string(), select_config() and check_cpu_for_microarchitecture() methods in the CPP file when
 //       adding new microarchitectures.
@@ -26,6 +31,18 @@ enum class Microarchitecture {
 
 const char* to_string(Microarchitecture uarch);
 
+// How the address matrices are applied to an address (see DRAMConfig::prepare_translation).
+enum class TranslationMethod {
+  // one parity per matrix row
+  PARITY,
+  // XOR of one precomputed table entry per address byte
+  LOOKUP_TABLE,
+  // a single PEXT, only if every row selects a single address bit and the rows select descending bits
+  PEXT,
+};
+
+const char* to_string(TranslationMethod method);
+
 class DRAMConfig {
 public:
   // Get the selected DRAMConfig instance.
@@ -36,7 +53,7 @@ public:
   static DRAMConfig& get();
 
   [[nodiscard]] Microarchitecture get_uarch() const { return uarch; }
-  [[nodiscard]] uint64_t get_sync_ref_threshold() const { return sync_ref_threshold; }
+  [[nodiscard]] uint64_t get_sync_ref_threshold() const { return sync_ref_threshold.load(); }
   void set_sync_ref_threshold(size_t threshold) { sync_ref_threshold = threshold; }
 
   [[nodiscard]] size_t memory_size() const { return (1ULL << total_bits()); }
@@ -56,12 +73,23 @@ public:
   }
 
   [[nodiscard]] size_t apply_dram_matrix(size_t phys_addr) const {
-    return apply_matrix(dram_matrix, phys_addr);
+    return translate(dram_translation, dram_matrix, phys_addr);
   }
   [[nodiscard]] size_t apply_addr_matrix(size_t linearized_dram_addr) const {
-    return apply_matrix(addr_matrix, linearized_dram_addr);
+    return translate(addr_translation, addr_matrix, linearized_dram_addr);
   }
 
+  // The methods used for apply_dram_matrix() and apply_addr_matrix(), selected by select_config().
+  [[nodiscard]] TranslationMethod get_dram_translation_method() const { return dram_translation.method; }
+  [[nodiscard]] TranslationMethod get_addr_translation_method() const { return addr_translation.method; }
+
+  // Forces the given method for both matrices if it is applicable (e.g., to compare the methods), otherwise selects
+  // the fastest method available. Returns whether the given method is used.
+  bool set_translation_method(TranslationMethod method);
+
+  // Selects the fastest method that is applicable to each matrix on this microarchitecture.
+  void select_fastest_translation();
+
   [[nodiscard]] size_t linearize_dram_addr(size_t bank, size_t row, size_t column) const {
     // This essentially wraps around any {bank,row,col} that is larger than allowed.
     return ((bank & bank_mask) << bank_shift)
@@ -77,8 +105,44 @@ public:
   }
 
 private:
+  // A matrix prepared for fast translations. As the matrices are linear over GF(2), applying a matrix to an address is
+  // the XOR of applying it to each byte of the address on its own, which is precomputed for all 256 values of each byte.
+  struct Translation {
+    TranslationMethod method { TranslationMethod::PARITY };
+    // PEXT: the address bits selected by the matrix rows
+    size_t pext_mask { 0 };
+    // LOOKUP_TABLE: tables[k][b] is the matrix applied to (b << (8 * k))
+    std::vector<std::array<size_t, 256>> tables;
+  };
+
   [[nodiscard]] static size_t apply_matrix(const std::vector<size_t>& matrix, size_t addr);
 
+  [[nodiscard]] static size_t translate(const Translation& translation, const std::vector<size_t>& matrix, size_t addr) {
+    switch (translation.method) {
+      case TranslationMethod::LOOKUP_TABLE: {
+        size_t result = 0;
+        for (size_t k = 0; k < translation.tables.size(); k++) {
+          result ^= translation.tables[k][(addr >> (8 * k)) & 0xff];
+        }
+        return result;
+      }
+#ifdef __BMI2__
+      case TranslationMethod::PEXT:
+        return _pext_u64(addr, translation.pext_mask);
+#endif
+      default:
+        return apply_matrix(matrix, addr);
+    }
+  }
+
+  // Prepares the given method for the matrix, returns false (and leaves the translation unchanged) if the method is
+  // not applicable.
+  [[nodiscard]] bool prepare_translation(Translation& translation, const std::vector<size_t>& matrix,
+                                         TranslationMethod method) const;
+
+  // Prepares the fastest method that is applicable to the matrix on this microarchitecture.
+  void prepare_fastest_translation(Translation& translation, const std::vector<size_t>& matrix) const;
+
   DRAMConfig() = default;
 
   // Checks that all preconditions for the configuration are fulfilled, or fails by calling exit().
@@ -87,8 +151,8 @@ private:
   // Meta information not encoded in the shifts, masks and matrices.
   Microarchitecture uarch;
 
-  // Information only dependent on the uarch.
-  uint64_t sync_ref_threshold;
+  // Information only dependent on the uarch. Atomic as patterns may be jitted on a helper thread (see FuzzPipeline).
+  std::atomic<uint64_t> sync_ref_threshold { 0 };
 
   // FIXME: Currently, phys_dram_offset is only supported in that it can only affects bits above what we calculate with
   //        the matrix. This is checked with an assertion. In the future, it may make sense to be more clever in
@@ -111,6 +175,9 @@ private:
   std::vector<size_t> dram_matrix;
   // maps DRAM addr (subch | rank | bankgroup | bank | row | col) -> physical addr
   std::vector<size_t> addr_matrix;
+
+  Translation dram_translation;
+  Translation addr_translation;
 };
 
 #endif //BLACKSMITH_DRAMCONFIG_HPP_
@@ -30,6 +30,11 @@ class DramAnalyzer {
   /// Finds threshold.
   void find_threshold();
 
+  [[nodiscard]] size_t get_threshold() const { return threshold; }
+
+  /// Uses a previously determined threshold (e.g., from a CalibrationProfile) instead of calling find_threshold().
+  void set_threshold(size_t value) { threshold = value; }
+
   /// Finds addresses of the same bank causing bank conflicts when accessed sequentially
   void find_bank_conflicts();
 
@@ -60,6 +65,10 @@ class DramAnalyzer {
   /// Determine the number of possible activations within a refresh interval.
   size_t count_acts_per_trefi();
 
+  /// Determine the number of possible activations within a refresh interval by alternately accessing a and b, which
+  /// must be in different rows of the same bank.
+  static size_t count_acts_per_trefi(volatile char *a, volatile char *b);
+
   size_t find_sync_ref_threshold();
   void check_sync_ref_threshold(size_t sync_ref_threshold);
 
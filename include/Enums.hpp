@@ -55,7 +55,40 @@ enum FENCE_TYPE {
   SFENCE,
 };
 
+// how CodeJitter emits the aggressor accesses of a hammering function
+enum class JIT_EMITTER {
+  // one 64-bit immediate load (plus counter updates) per access and flush
+  UNROLLED,
+  // accesses and flushes are encoded relative to a base register, counters are updated once per pattern round
+  COMPACT,
+};
+
+// how the hammering functions synchronize with REF
+enum class SYNC_MODE {
+  // access rows until an access is slowed down by REF (see CodeJitter::sync_ref_nonrepeating)
+  PROBE,
+  // wait for the REF edge predicted by the RefPhaseTracker without accessing any rows
+  PREDICTED,
+};
+
+// how the hammering threads are placed on the CPUs (see CpuTopology)
+enum class PLACEMENT_POLICY {
+  // thread i on CPU (offset + i) % 16
+  LEGACY,
+  // one thread per physical core
+  PHYSICAL_CORES,
+  // both hardware threads of a core before using the next core
+  SMT_PAIRS,
+  // all threads on the physical cores of a single CCX (L3 cache)
+  SAME_CCX,
+  // one thread per physical core, round-robin over the CCXs
+  SPREAD,
+};
+
 std::string to_string(SCHEDULING_POLICY policy);
 std::string to_string(FENCE_TYPE type);
+std::string to_string(JIT_EMITTER emitter);
+std::string to_string(SYNC_MODE mode);
+std::string to_string(PLACEMENT_POLICY policy);
 
 #endif //BLACKSMITH_INCLUDE_UTILITIES_ENUMS_HPP_
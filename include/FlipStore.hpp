@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include "BitFlip.hpp"
+#include "DRAMAddr.hpp"
+
+// A contiguous range of flips in the FlipStore, e.g., all flips found by a single memory check.
+struct FlipRange {
+  uint32_t begin = 0;
+  uint32_t count = 0;
+
+  [[nodiscard]] uint32_t end() const { return begin + count; }
+  [[nodiscard]] bool empty() const { return count == 0; }
+};
+
+// Columnar storage for all bit flips observed during a fuzzing campaign.
+// Each flip only takes 14 bytes (packed DRAM address, bitmask, corrupted data and a timestamp relative to the first
+// flip) instead of a full BitFlip. Mappers and reports only keep FlipRanges into this store, which makes copying
+// them independent of the number of flips they found. Flips are only ever appended, hence ranges stay valid for the
+// whole campaign. The store is not synchronized and must only be modified by the thread that checks the memory.
+class FlipStore {
+private:
+  FlipStore() = default;
+
+  // DRAMAddr packed as | mapping_id (8 bits) | bank (16 bits) | row (24 bits) | column (16 bits) |
+  std::vector<uint64_t> addresses;
+  std::vector<uint8_t> bitmasks;
+  std::vector<uint8_t> corrupted_data;
+  // the observation time in seconds relative to epoch
+  std::vector<uint32_t> time_deltas;
+
+  // the observation time of the first flip added to the store
+  time_t epoch { 0 };
+
+  static uint64_t pack(const DRAMAddr &addr);
+
+  static DRAMAddr unpack(uint64_t packed);
+
+public:
+  static FlipStore &get();
+
+  /// appends the given flips and returns the range they occupy in the store.
+  FlipRange add(const std::vector<BitFlip> &flips);
+
+  /// reconstructs the flip at the given index.
+  [[nodiscard]] BitFlip at(size_t idx) const;
+
+  /// reconstructs all flips in the given range.
+  [[nodiscard]] std::vector<BitFlip> get_flips(const FlipRange &range) const;
+
+  /// the total number of flipped bits in the given range.
+  [[nodiscard]] size_t count_bit_corruptions(const FlipRange &range) const;
+
+  /// the number of flips in the store.
+  [[nodiscard]] size_t size() const { return bitmasks.size(); }
+
+  /// the number of bytes occupied by the stored flips.
+  [[nodiscard]] size_t memory_usage() const;
+};
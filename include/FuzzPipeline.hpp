@@ -0,0 +1,45 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "HammerSuite.hpp"
+
+// Prepares fuzzing rounds on a helper core while the current round is hammered.
+// A producer thread, pinned to a core that is not used for hammering, runs HammerSuite::prepare_round (pattern
+// generation, address mapping, export and JIT for the first location) and hands the result over through a single
+// slot; it then immediately starts with the next round and blocks until the slot was emptied by next().
+class FuzzPipeline {
+private:
+  HammerSuite &suite;
+  Args args;
+  int cpu;
+
+  std::mutex mutex;
+  std::condition_variable slot_changed;
+  std::optional<PreparedRound> slot;
+  bool stopped { false };
+
+  // the time next() had to wait for the producer
+  std::chrono::steady_clock::duration wait_time { 0 };
+
+  std::thread producer;
+
+  void produce();
+
+public:
+  FuzzPipeline(HammerSuite &suite, const Args &args, int cpu);
+
+  FuzzPipeline(const FuzzPipeline &) = delete;
+  FuzzPipeline &operator=(const FuzzPipeline &) = delete;
+
+  /// stops the producer; a round that is currently prepared is finished and discarded.
+  ~FuzzPipeline();
+
+  /// takes the next prepared round, waiting for the producer if it is not ready yet.
+  PreparedRound next();
+
+  [[nodiscard]] std::chrono::steady_clock::duration get_wait_time() const { return wait_time; }
+};
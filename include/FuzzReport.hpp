@@ -1,13 +1,22 @@
 #pragma once
 #include "FuzzingParameterSet.hpp"
 #include "LocationReport.hpp"
+#include <span>
+#include <vector>
 
+// The results of one fuzzing run, i.e., of all locations a set of patterns was hammered at.
 class FuzzReport {
 private:
   std::vector<LocationReport> reports;
 public:
-  std::vector<LocationReport> get_reports();
-  size_t sum_flips();
-  void add_report(LocationReport report);
-};
+  FuzzReport() = default;
+  FuzzReport(const FuzzReport &) = delete;
+  FuzzReport &operator=(const FuzzReport &) = delete;
+  FuzzReport(FuzzReport &&) = default;
+  FuzzReport &operator=(FuzzReport &&) = default;
 
+  [[nodiscard]] std::span<const LocationReport> get_reports() const;
+  [[nodiscard]] size_t sum_flips() const;
+  void add_report(LocationReport &&report);
+  void reserve(size_t locations);
+};
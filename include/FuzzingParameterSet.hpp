@@ -140,6 +140,12 @@ class FuzzingParameterSet {
 
   void set_fixed_acts_per_trefi(int fixed_acts_per_trefi);
 
+  /// sizes the pattern for a measured number of ACTs per tREFI: each of the num_refresh_intervals intervals of the
+  /// pattern is filled with acts_per_trefi ACTs and the pattern is hammered for a whole number of refresh windows.
+  /// The other semi-dynamic parameters are kept, except for the base period, which needs to divide the pattern.
+  /// Falls back to randomize_parameters() if acts_per_trefi is too low to build a pattern from.
+  void set_act_budget(int acts_per_trefi);
+
   int get_bank_change_percentage();
   
   void set_bank_change_percentage(float_t percentage);
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Aligns the start of the hammering threads of one round. The last thread to arrive publishes a deadline `margin` TSC
+// cycles in the future and all threads spin on the TSC until it has passed, so they start within a few cycles of each
+// other instead of depending on how fast each of them notices that a barrier opened. Single use.
+class StartDeadline {
+public:
+  // enough for the other threads to observe the deadline before it passes
+  static constexpr uint64_t DEFAULT_MARGIN = 1 << 15;
+
+private:
+  const size_t num_threads;
+  const uint64_t margin;
+  std::atomic<size_t> waiting { 0 };
+  std::atomic<uint64_t> deadline { 0 };
+
+public:
+  explicit StartDeadline(size_t num_threads, uint64_t margin = DEFAULT_MARGIN)
+      : num_threads(num_threads), margin(margin) {}
+
+  /// waits for all threads and returns the TSC at which this thread passed the deadline
+  uint64_t arrive_and_wait();
+};
+
+// Long-lived hammering threads. Worker i is pinned to CPU cpus[i] (see CpuTopology::place) once, when it is created, and then
+// sleeps until run() hands it a task; in contrast to spawning threads for every location, this way thread creation,
+// pinning and the migration to the target core are not part of any hammering round.
+class HammerPool {
+public:
+  using Task = std::function<void()>;
+
+private:
+  std::vector<std::thread> workers;
+
+  // incremented for every batch of tasks (and once more to stop the workers)
+  std::atomic<uint64_t> generation { 0 };
+  // the number of workers that still have to finish the current batch
+  std::atomic<size_t> remaining { 0 };
+  bool stopping { false };
+  std::vector<Task> *tasks { nullptr };
+
+  std::vector<int> cpus;
+
+  void work(size_t idx, int cpu);
+
+public:
+  explicit HammerPool(std::vector<int> cpus);
+
+  HammerPool(const HammerPool &) = delete;
+  HammerPool &operator=(const HammerPool &) = delete;
+
+  ~HammerPool();
+
+  [[nodiscard]] size_t size() const { return workers.size(); }
+
+  [[nodiscard]] const std::vector<int> &get_cpus() const { return cpus; }
+
+  /// runs tasks[i] on worker i and waits until all tasks finished; there must not be more tasks than workers.
+  void run(std::vector<Task> &tasks);
+};
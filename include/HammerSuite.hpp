@@ -1,15 +1,18 @@
 #pragma once
-#include <barrier>
 #include <chrono>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <random>
 #include <vector>
+#include "CalibrationProfile.hpp"
 #include "CodeJitter.hpp"
 #include "Enums.hpp"
 #include "FuzzReport.hpp"
 #include "FuzzingParameterSet.hpp"
+#include "HammerPool.hpp"
 #include "HammeringPattern.hpp"
+#include "MappedPattern.hpp"
 #include "Memory.hpp"
 #include "PatternAddressMapper.hpp"
 #include "LocationReport.hpp"
@@ -40,6 +43,28 @@ struct Args {
   ColumnRandomizationStyle randomization_style = ColumnRandomizationStyle::NONE;
   bool compensate_access_count = false;
   int simple_num_aggs = -1;
+  JIT_EMITTER jit_emitter = JIT_EMITTER::UNROLLED;
+  SYNC_MODE sync_mode = SYNC_MODE::PROBE;
+  // size the patterns by the measured ACTs per tREFI of their bank instead of a random number
+  bool measured_acts = false;
+  bool benchmark_jit = false;
+  bool benchmark_translation = false;
+  bool pipeline = false;
+  PLACEMENT_POLICY placement = PLACEMENT_POLICY::PHYSICAL_CORES;
+  size_t mappings = 1;
+  // if set, the cells of this experiment matrix are run instead (see run_matrix in main.cpp)
+  std::string matrix;
+  std::string matrix_dir = "matrix";
+  // the calibration is loaded from this file and only measured if it does not exist or belongs to another machine
+  std::string profile = CalibrationProfile::DEFAULT_PATH;
+  bool recalibrate = false;
+};
+
+// the patterns of a fuzzing round, mapped to their first location
+struct PreparedRound {
+  std::vector<MappedPattern> patterns;
+  // the patterns as exported for the first location
+  std::vector<PatternIR> exported;
 };
 
 class HammerSuite {
@@ -47,30 +72,56 @@ private:
   size_t current_pattern_id;
   std::map<size_t, HammeringPattern> patterns;
   void hammer_fn(size_t id, 
-                 std::vector<volatile char *> &pattern, 
+                 PatternIR &pattern, 
                  std::vector<volatile char *> &non_accessed_rows, 
                  CodeJitter &jitter,
                  FuzzingParameterSet &params, 
-                 std::barrier<> &start_barrier, 
+                 StartDeadline &start, 
                  RefreshTimer &timer,
                  FENCE_TYPE fence_type,
-                 std::chrono::time_point<std::chrono::steady_clock> &start,
-                 std::chrono::time_point<std::chrono::steady_clock> &end);
+                 HammerTiming &timing);
   void check_effective_patterns(std::vector<FuzzReport> &patterns, Args &args);
   Memory &memory;
+  // if set, used instead of calibrating a new RefreshTimer for every location
+  std::unique_ptr<RefreshTimer> refresh_timer;
+  // the profile refresh_timer was created from, updated if the REF threshold drifts
+  CalibrationProfile *profile = nullptr;
+  std::chrono::steady_clock::time_point last_drift_check;
+  // the ACTs per tREFI of each bank for the current number of threads, empty unless Args::measured_acts is set
+  std::vector<uint64_t> act_budget;
+  // the pinned threads all patterns are hammered on, created on first use
+  std::unique_ptr<HammerPool> hammer_pool;
+  HammerPool &get_hammer_pool(Args &args, size_t num_workers);
   static std::mt19937 engine;
 public:
   HammerSuite(Memory &memory);
   static void set_seed(uint64_t seed);
+  /// calibrates the RefreshTimer (and sync REF threshold) once for all following locations instead of once per location
+  void calibrate();
+  /// like calibrate(), but uses the REF threshold of a stored profile instead of measuring it
+  void calibrate(CalibrationProfile &profile);
+  /// checks every couple of seconds whether the REF threshold drifted away from the calibrated one and recalibrates if
+  /// it did (and updates the profile)
+  void check_calibration();
+  /// measures the ACTs per tREFI of each bank while args.threads threads hammer different banks at once (on the
+  /// hammering threads), unless the profile already contains them for this number of threads
+  void measure_act_budget(Args &args);
   MappedPattern build_mapped(FuzzingParameterSet &params, bool simple, ColumnRandomizationStyle randomization_style);
   HammeringPattern generate_pattern(FuzzingParameterSet &params, bool simple, ColumnRandomizationStyle randomization_style);
   MappedPattern build_mapped(int bank, FuzzingParameterSet &params, bool simple, ColumnRandomizationStyle randomization_style);
   MappedPattern map_pattern(int bank, HammeringPattern &pattern, FuzzingParameterSet &params, bool simple, ColumnRandomizationStyle randomization_style);
   MappedPattern map_pattern(HammeringPattern &pattern, FuzzingParameterSet &params, bool simple, ColumnRandomizationStyle randomization_style);
-  std::vector<FuzzReport> filter_and_analyze_flips(std::vector<FuzzReport> &patterns, std::string &filepath);
+  std::vector<const FuzzReport *> filter_and_analyze_flips(const std::vector<FuzzReport> &patterns, std::string &filepath);
   FuzzReport fuzz(Args &args);
-  LocationReport fuzz_pattern(std::vector<MappedPattern> &patterns, Args &args);
+  /// generates and maps the patterns of a fuzzing round and exports them for their first location; if jit is set,
+  /// they are also jitted using the current sync REF threshold. Does not access the allocation, hence it can run while
+  /// another round is hammered (see FuzzPipeline).
+  PreparedRound prepare_round(Args &args, bool jit);
+  /// hammers a prepared round on all locations.
+  FuzzReport run_round(PreparedRound &round, Args &args);
+  LocationReport fuzz_pattern(std::vector<MappedPattern> &patterns, Args &args, std::vector<PatternIR> *exported = nullptr);
   std::vector<LocationReport> fuzz_location(std::vector<HammeringPattern> &patterns, size_t locations, Args &args);
-  std::vector<LocationReport> fuzz_location(std::vector<MappedPattern> &patterns, size_t locations, Args &args);
+  std::vector<LocationReport> fuzz_location(std::vector<MappedPattern> &patterns, size_t locations, Args &args,
+                                            std::vector<PatternIR> *first_exported = nullptr);
   std::vector<FuzzReport> auto_fuzz(Args args);
 };
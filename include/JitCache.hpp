@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Enums.hpp"
+#include "PatternIR.hpp"
+#include "asmjit/core/codeholder.h"
+#include "asmjit/core/jitruntime.h"
+
+struct HammeringData;
+
+// Everything CodeJitter::jit_strict's output depends on.
+struct JitCacheKey {
+  std::vector<PatternOp> pattern;
+  FLUSHING_STRATEGY flushing;
+  FENCING_STRATEGY fencing;
+  FENCE_TYPE fence_type;
+  int total_num_activations;
+  uint64_t sync_ref_threshold;
+  JIT_EMITTER emitter;
+  SYNC_MODE sync_mode;
+
+  bool operator==(const JitCacheKey &other) const = default;
+};
+
+struct JitCacheKeyHash {
+  size_t operator()(const JitCacheKey &key) const;
+};
+
+// A jitted hammering function owned by the JitCache. The code is released once the entry was evicted and the last
+// CodeJitter using it let go of it.
+struct JitCacheEntry {
+  asmjit::JitRuntime *runtime = nullptr;
+  int (*fn)(HammeringData*) = nullptr;
+  size_t code_size = 0;
+
+  JitCacheEntry() = default;
+  JitCacheEntry(const JitCacheEntry &) = delete;
+  JitCacheEntry &operator=(const JitCacheEntry &) = delete;
+  ~JitCacheEntry();
+};
+
+// Content-addressed cache of hammering functions generated by CodeJitter::jit_strict.
+// Replaying the same pattern at the same location (e.g., in HammerSuite::check_effective_patterns) then skips the
+// assembly and the allocation of executable memory. The least recently used functions are evicted once more than
+// MAX_ENTRIES functions are cached.
+class JitCache {
+private:
+  using LruList = std::list<std::pair<JitCacheKey, std::shared_ptr<JitCacheEntry>>>;
+
+  std::mutex mutex;
+
+  // all cached functions are added to this runtime
+  asmjit::JitRuntime runtime;
+
+  // the most recently used entry is at the front
+  LruList lru;
+  std::unordered_map<JitCacheKey, LruList::iterator, JitCacheKeyHash> entries;
+
+  size_t hits { 0 };
+  size_t misses { 0 };
+
+  JitCache() = default;
+
+public:
+  static constexpr size_t MAX_ENTRIES = 256;
+
+  static JitCache &get();
+
+  /// the runtime the cached code must be generated for.
+  asmjit::JitRuntime &get_runtime() { return runtime; }
+
+  /// returns the cached function for key, or nullptr if there is none.
+  std::shared_ptr<JitCacheEntry> lookup(const JitCacheKey &key);
+
+  /// adds the code in holder to the cache's runtime and stores it under key.
+  std::shared_ptr<JitCacheEntry> insert(JitCacheKey key, asmjit::CodeHolder &holder);
+
+  [[nodiscard]] size_t get_hits() const { return hits; }
+  [[nodiscard]] size_t get_misses() const { return misses; }
+};
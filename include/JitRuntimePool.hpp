@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "asmjit/core/jitruntime.h"
+
+// A process-wide pool of asmjit runtimes.
+// Creating a JitRuntime sets up its own executable-memory allocator; as mappings (and with them their CodeJitter) are
+// copied and destroyed all the time, CodeJitter only borrows a runtime from this pool while it holds jitted code and
+// returns it in cleanup(). Returned runtimes keep their (now empty) code blocks, so later rounds reuse that memory
+// instead of mapping new pages.
+class JitRuntimePool {
+private:
+  std::mutex mutex;
+
+  std::vector<std::unique_ptr<asmjit::JitRuntime>> idle;
+
+  // the number of runtimes currently borrowed by CodeJitter instances (to catch runtimes that are released twice)
+  size_t in_use { 0 };
+
+  // the number of runtimes ever created by the pool
+  size_t created { 0 };
+
+  JitRuntimePool() = default;
+
+public:
+  // the maximum number of idle runtimes that are kept for later reuse
+  static constexpr size_t MAX_IDLE_RUNTIMES = 64;
+
+  static JitRuntimePool &get();
+
+  /// borrows a runtime from the pool, creating a new one if no idle runtime is available.
+  asmjit::JitRuntime *acquire();
+
+  /// returns a runtime to the pool; all functions added to it must have been released before.
+  void release(asmjit::JitRuntime *runtime);
+
+  /// the number of runtimes ever created by the pool.
+  size_t num_created();
+};
@@ -1,25 +1,52 @@
 #pragma once
 #include "BitFlip.hpp"
+#include "FlipStore.hpp"
 #include "FuzzingParameterSet.hpp"
 #include "MappedPattern.hpp"
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <span>
 #include <vector>
 
+// when a hammering thread started and finished its run
+struct HammerTiming {
+  std::chrono::time_point<std::chrono::steady_clock> start;
+  std::chrono::time_point<std::chrono::steady_clock> end;
+  uint64_t start_tsc = 0;
+  uint64_t end_tsc = 0;
+};
+
 typedef struct {
   MappedPattern pattern;
   size_t flips;
   std::chrono::duration<float_t> duration;
-  std::vector<BitFlip> bit_flips;
+  FlipRange bit_flips;
+  uint64_t start_tsc;
+  uint64_t end_tsc;
 } PatternReport;
 
+// The results of all patterns hammered concurrently at one location.
+// Reports are append-only and can only be moved in; they are handed out as read-only views so that the analysis never
+// copies a MappedPattern.
 class LocationReport {
 private:
   std::vector<PatternReport> reports;
 public:
-  std::vector<PatternReport> get_reports();
-  size_t sum_flips();
-  void add_report(PatternReport report);
-  std::chrono::duration<float> duration();
-};
+  LocationReport() = default;
+  LocationReport(const LocationReport &) = delete;
+  LocationReport &operator=(const LocationReport &) = delete;
+  LocationReport(LocationReport &&) = default;
+  LocationReport &operator=(LocationReport &&) = default;
 
+  [[nodiscard]] std::span<const PatternReport> get_reports() const;
+  [[nodiscard]] size_t sum_flips() const;
+  void add_report(PatternReport &&report);
+  [[nodiscard]] std::chrono::duration<float> duration() const;
+  /// the TSC cycles between the first and the last thread starting to hammer
+  [[nodiscard]] uint64_t start_skew() const;
+  /// start_skew() converted using the TSC rate observed during hammering
+  [[nodiscard]] std::chrono::duration<float> start_skew_time() const;
+  /// the share (in percent) of the time from the first start to the last end during which all threads hammered
+  [[nodiscard]] float overlap() const;
+};
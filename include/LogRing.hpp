@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+enum class LogLevel : uint8_t {
+  INFO,
+  HIGHLIGHT,
+  ERROR,
+  DATA,
+  DEBUG,
+  ANALYSIS_STAGE,
+  SUCCESS,
+  FAILURE,
+  BITFLIP,
+};
+
+// A fixed-size binary log record. Text messages are copied into the payload (split over several records if they do not
+// fit); Logger::logf() records only store the format string and the raw argument bytes and are rendered by the
+// flusher thread.
+struct LogRecord {
+  static constexpr size_t PAYLOAD_SIZE = 100;
+  // set on the first/last record of a message that is split over several records
+  static constexpr uint8_t FIRST = 1;
+  static constexpr uint8_t LAST = 2;
+  static constexpr uint8_t NEWLINE = 4;
+
+  uint64_t tsc;
+  // appends the message to out; nullptr for text records
+  void (*render)(const LogRecord &record, std::string &out);
+  // a string literal
+  const char *format;
+  LogLevel level;
+  uint8_t flags;
+  uint16_t length;
+  char payload[PAYLOAD_SIZE];
+};
+static_assert(sizeof(LogRecord) == 128);
+
+// A single-producer single-consumer ring of log records: the producer is the thread that logs, the consumer the
+// Logger's flusher thread. The producer never waits: if the ring is full, the record is dropped and counted.
+class LogRing {
+public:
+  static constexpr size_t CAPACITY = 4096;
+
+private:
+  std::unique_ptr<LogRecord[]> records { new LogRecord[CAPACITY] };
+  // written by the consumer
+  alignas(64) std::atomic<size_t> head { 0 };
+  // written by the producer
+  alignas(64) std::atomic<size_t> tail { 0 };
+  std::atomic<size_t> dropped { 0 };
+
+public:
+  /// the record at position i after the last committed one, if there is space for n more records (called by the
+  /// producer)
+  LogRecord *reserve(size_t i, size_t n) {
+    auto t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) + n > CAPACITY) {
+      return nullptr;
+    }
+    return &records[(t + i) % CAPACITY];
+  }
+
+  /// publishes the next n reserved records (called by the producer)
+  void commit(size_t n) { tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+  void drop() { dropped.fetch_add(1, std::memory_order_relaxed); }
+
+  /// hands all published records to consume and returns their number (called by the consumer)
+  template<typename F>
+  size_t drain(F &&consume) {
+    auto h = head.load(std::memory_order_relaxed);
+    auto t = tail.load(std::memory_order_acquire);
+    for (auto i = h; i != t; i++) {
+      consume(records[i % CAPACITY]);
+    }
+    head.store(t, std::memory_order_release);
+    return t - h;
+  }
+
+  /// the number of records dropped since the last call
+  size_t take_dropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+};
@@ -6,10 +6,19 @@
 #ifndef BLACKSMITH_INCLUDE_LOGGER_HPP_
 #define BLACKSMITH_INCLUDE_LOGGER_HPP_
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <fstream>
 #include <memory>
 #include <cstdint>
+#include <cstring>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "LogRing.hpp"
 
 template<typename ... Args>
 std::string format_string(const std::string &format, Args ... args) {
@@ -20,6 +29,8 @@ std::string format_string(const std::string &format, Args ... args) {
   return std::string(buf.get(), buf.get() + size - 1); // We don't want the '\0' inside
 }
 
+// Logging never blocks the calling thread: every thread appends binary records to its own LogRing, and a background
+// thread merges the rings by timestamp and writes them into the logfile.
 class Logger {
  private:
   Logger();
@@ -34,8 +45,32 @@ class Logger {
 
   unsigned long timestamp_start{};
 
+  // the rings of all threads that logged so far; a ring is removed once its thread exited and it was drained
+  std::vector<std::shared_ptr<LogRing>> rings;
+
+  std::thread flusher;
+
+  std::atomic<bool> stopping{false};
+
+  // the calling thread's ring (registered on first use)
+  static LogRing &ring();
+
+  static void log_text(LogLevel level, const std::string &message, bool newline);
+
+  template<typename ... Args>
+  static void render_values(const LogRecord &record, std::string &out);
+
+  void flush_loop();
+
+  // drains all rings and writes their records into the logfile
+  void flush_rings();
+
+  void write_record(const LogRecord &record, std::string &line);
+
  public:
 
+  ~Logger();
+
   static void initialize();
 
   static void close();
@@ -64,6 +99,48 @@ class Logger {
   static void log_success(const std::string &message, bool newline = true);
 
   static void log_failure(const std::string &message, bool newline = true);
+
+  /// logs a message without formatting it on the calling thread: only the arguments (numbers or void pointers) are
+  /// copied, the format string must be a literal as it is used by the flusher thread later on.
+  template<typename ... Args>
+  static void logf(LogLevel level, const char *format, Args ... args);
 };
 
+template<typename ... Args>
+void Logger::render_values(const LogRecord &record, std::string &out) {
+  std::tuple<Args...> values;
+  size_t offset = 0;
+  std::apply([&](auto &... value) {
+    ((std::memcpy(&value, record.payload + offset, sizeof(value)), offset += sizeof(value)), ...);
+  }, values);
+  std::apply([&](auto ... value) {
+    char buf[256];
+    int size = snprintf(buf, sizeof(buf), record.format, value ...);
+    if (size > 0) out.append(buf, std::min<size_t>(size, sizeof(buf) - 1));
+  }, values);
+}
+
+template<typename ... Args>
+void Logger::logf(LogLevel level, const char *format, Args ... args) {
+  static_assert(((std::is_arithmetic_v<Args> || std::is_same_v<Args, void *>) && ...),
+                "only numbers and void pointers can be logged without formatting");
+  static_assert((sizeof(Args) + ... + 0) <= LogRecord::PAYLOAD_SIZE, "too many arguments");
+
+  auto &r = ring();
+  auto *record = r.reserve(0, 1);
+  if (record == nullptr) {
+    r.drop();
+    return;
+  }
+  record->tsc = __builtin_ia32_rdtsc();
+  record->render = &render_values<Args...>;
+  record->format = format;
+  record->level = level;
+  record->flags = LogRecord::FIRST | LogRecord::LAST | LogRecord::NEWLINE;
+  size_t offset = 0;
+  ((std::memcpy(record->payload + offset, &args, sizeof(args)), offset += sizeof(args)), ...);
+  record->length = offset;
+  r.commit(1);
+}
+
 #endif //BLACKSMITH_INCLUDE_LOGGER_HPP_
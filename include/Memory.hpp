@@ -9,9 +9,21 @@
 #include <cstdint>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
+#include "BitFlip.hpp"
+#include "CounterRng.hpp"
+#include "FlipStore.hpp"
 #include "DramAnalyzer.hpp"
 #include "PatternAddressMapper.hpp"
+#include "RowFootprint.hpp"
+
+// the amount of memory a single worker checks or initializes at a time
+#define SWEEP_SHARD_SIZE (2*1024*1024)
+
+// how long (at most) to wait for khugepaged to back the allocation by transparent huge pages, and how often to check
+#define THP_WAIT_TIMEOUT_MS 10000
+#define THP_POLL_INTERVAL_US 100000
 
 enum class DATA_PATTERN : char {
   ZEROES, ONES, RANDOM
@@ -29,19 +41,67 @@ class Memory {
   // the size of the allocated memory area in bytes
   uint64_t size;
 
+  // the allocation consists of num_mappings consecutive areas of mapping_size bytes, each of them registered as a
+  // separate DRAMAddr mapping
+  uint64_t mapping_size = 0;
+  size_t num_mappings = 1;
+
   // whether this memory allocation is backed up by a superage
   const bool superpage;
 
   uint64_t seed;
 
-  size_t check_memory_internal(PatternAddressMapper &mapping, const volatile char *start,
-                               const volatile char *end, bool reproducibility_mode, bool verbose);
+  // generates the (pseudo)random data pattern; the expected value of each word only depends on (seed, offset)
+  CounterRng rng;
+
+  // the data pattern the memory was initialized with during the last call to initialize
+  DATA_PATTERN data_pattern = DATA_PATTERN::RANDOM;
+
+  // the checksum of every page as written by initialize(), used to skip the byte-level comparison of unmodified pages
+  std::vector<uint32_t> page_checksums;
+
+  // fills page with the values expected at the given offset (relative to start_address) of the allocation
+  void fill_expected(uint32_t *page, uint64_t offset, size_t nwords) const;
+
+  // stores the flips found for a mapping in the mapping itself (unless in reproducibility mode) and in flipped_bits
+  void store_flips(PatternAddressMapper &mapping, const std::vector<BitFlip> &flips, bool reproducibility_mode);
+
+  // checks exactly the cache lines that belong to the given DRAM row, restores corrupted words and appends found flips
+  size_t check_footprint(const RowFootprint &footprint, std::vector<BitFlip> &flips, bool verbose);
+
+  // returns true if the cache line at the given offset still holds its expected values
+  bool line_matches(uint64_t line_offset) const;
+
+  // compares nwords words at offset with their expected values byte-by-byte, restores corrupted words and appends
+  // the found flips
+  size_t diff_words(uint64_t offset, const uint32_t *expected, size_t nwords, std::vector<BitFlip> &flips,
+                    bool verbose);
+
+  // converts [start, end) into page-aligned offsets relative to start_address; returns false for invalid arguments
+  bool get_page_range(const volatile char *start, const volatile char *end,
+                      uint64_t &start_offset, uint64_t &end_offset) const;
+
+  // compares the page at page_offset with the expected values, restores corrupted words and appends found flips;
+  // expected is a page-sized scratch buffer that is only filled if the page's checksum does not match
+  size_t check_page(uint64_t page_offset, uint32_t *expected, std::vector<BitFlip> &flips, bool verbose);
+
+  // the number of bytes of the allocation that are backed by transparent huge pages (according to /proc/self/smaps)
+  [[nodiscard]] size_t get_anon_huge_bytes() const;
+
+  // polls until the whole allocation is backed by transparent huge pages or the timeout expired
+  void wait_for_huge_pages(size_t timeout_ms);
+
+  // spreads the mappings over the NUMA nodes (round-robin), must be called before the memory is touched
+  void bind_mappings_to_nodes();
 
   static uint64_t get_pfn(uint64_t v_addr); 
  
 public:
 
-  static uint64_t get_physical_address(uint64_t v_addr); 
+  static uint64_t get_physical_address(uint64_t v_addr);
+
+  // translates a batch of virtual addresses at once, the physical addresses are written to paddrs
+  static void get_physical_addresses(const std::vector<uint64_t> &vaddrs, std::vector<uint64_t> &paddrs);
 
   // the flipped bits detected during the last call to check_memory
   std::vector<BitFlip> flipped_bits;
@@ -51,15 +111,24 @@ public:
 
   ~Memory();
 
-  void allocate_memory(size_t mem_size);
+  /// allocates num_mappings areas of mem_size bytes each (rounded up to 1 GiB superpages if superpages are used)
+  void allocate_memory(size_t mem_size, size_t num_mappings = 1);
 
   void initialize(DATA_PATTERN data_pattern);
 
   size_t check_memory(const volatile char *start, const volatile char *end);
 
+  // checks [start, end) for flips using num_threads workers (0 = one per available core). The flips found by each
+  // worker are merged in address order into flipped_bits.
+  size_t sweep_memory(const volatile char *start, const volatile char *end, size_t num_threads);
+
   size_t check_memory(PatternAddressMapper &mapping, bool reproducibility_mode, bool verbose);
 
   [[nodiscard]] volatile char *get_starting_address() const;
+  [[nodiscard]] size_t get_num_mappings() const { return num_mappings; }
+  [[nodiscard]] volatile char *get_mapping_address(size_t mapping_id) const {
+    return start_address + mapping_id*mapping_size;
+  }
   // NOTE: This may be larger than DRAMConfig::memory_size() due to rounding up in allocate_memory().
   [[nodiscard]] size_t get_allocation_size() const { return size; }
 
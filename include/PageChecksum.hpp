@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Hardware-accelerated (SSE4.2 crc32 instruction) checksums over the pages of the allocation.
+// Four CRC32C streams run over interleaved 8-byte words to hide the latency of the crc32 instruction; the stream
+// results are then folded into one 32-bit value. Any corruption that is confined to a single stream and flips at most
+// three bits is always detected, all other corruptions are missed with a probability of about 2^-32.
+class PageChecksum {
+public:
+  /// computes the checksum over len bytes starting at data; len must be a multiple of 32 bytes.
+  static uint32_t compute(const void *data, size_t len);
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Caches virtual-to-physical translations read from /proc/self/pagemap.
+// The pagemap file is opened once and kept open. Regions that are backed by huge pages (e.g., the 1 GB superpage) can
+// be registered with their page size: the PFN of each huge page is then read only once and all further lookups within
+// that page are answered by pure arithmetic. Addresses outside of registered regions are cached per 4 KB page.
+class PagemapCache {
+private:
+  struct Region {
+    uint64_t start;
+    uint64_t size;
+    uint64_t page_size;
+  };
+
+  PagemapCache() = default;
+
+  ~PagemapCache();
+
+  // the file descriptor of /proc/self/pagemap, opened lazily
+  int fd { -1 };
+
+  std::mutex mutex;
+
+  std::vector<Region> regions;
+
+  // maps the virtual base address of a (huge or base) page to its physical base address
+  std::unordered_map<uint64_t, uint64_t> translations;
+
+  // the base addresses of huge pages of registered regions that turned out not to be physically contiguous
+  std::unordered_set<uint64_t> fragmented_units;
+
+  // the physical address of the 4 KB page containing vaddr, or 0 if it is not available (e.g., missing privileges)
+  uint64_t read_pagemap(uint64_t vaddr);
+
+  // the size of the physically contiguous unit vaddr belongs to, i.e., a huge page or a 4 KB page
+  uint64_t get_unit_size(uint64_t vaddr) const;
+
+  uint64_t translate_locked(uint64_t vaddr);
+
+public:
+  static PagemapCache &get();
+
+  /// registers [start, start+size) to be backed by pages of page_size bytes each.
+  void add_region(uint64_t start, uint64_t size, uint64_t page_size);
+
+  /// removes a previously registered region and all of its cached translations.
+  void remove_region(uint64_t start);
+
+  /// returns the physical address of vaddr, or 0 if it cannot be determined.
+  uint64_t translate(uint64_t vaddr);
+
+  /// translates all addresses in vaddrs at once (holding the lock only once); the results are written to paddrs.
+  void translate(const std::vector<uint64_t> &vaddrs, std::vector<uint64_t> &paddrs);
+};
@@ -19,8 +19,10 @@
 #include "Aggressor.hpp"
 #include "AggressorAccessPattern.hpp"
 #include "BitFlip.hpp"
+#include "FlipStore.hpp"
 #include "FuzzingParameterSet.hpp"
 #include "CodeJitter.hpp"
+#include "PatternIR.hpp"
 
 class HammeringPattern;
 
@@ -42,9 +44,9 @@ class PatternAddressMapper {
   // the unique identifier of this pattern-to-address mapping
   std::string instance_id;
 
-  // a randomization engine
-  static std::mt19937 gen;
-  static std::mt19937 col_gen;
+  // a randomization engine (per thread, as rounds may be prepared on a helper thread while another one is hammered)
+  static thread_local std::mt19937 gen;
+  static thread_local std::mt19937 col_gen;
 
  public:
   std::unique_ptr<CodeJitter> code_jitter;
@@ -57,10 +59,17 @@ class PatternAddressMapper {
   // copy assignment operator
   PatternAddressMapper& operator=(const PatternAddressMapper& other);
 
+  // move constructor and move assignment operator (take over the CodeJitter instead of creating a new one)
+  PatternAddressMapper(PatternAddressMapper&& other) noexcept = default;
+  PatternAddressMapper& operator=(PatternAddressMapper&& other) noexcept = default;
+
   // information about the mapping (required for determining rows not belonging to this mapping)
   size_t min_row = 0;
   size_t max_row = 0;
+  // the bank as numbered in mapping 0; the aggressors are placed on the corresponding bank of mapping_id
   int bank_no = 0;
+  // the DRAMAddr mapping (i.e., superpage) the aggressors are placed in
+  int mapping_id = 0;
 
   // a global counter that makes sure that we test patterns on all banks equally often
   // it is incremented for each mapping and reset to 0 once we tested all banks (depending on num_probes_per_pattern
@@ -69,13 +78,17 @@ class PatternAddressMapper {
   static void set_bank_counter(int counter) {
     bank_counter = counter;
   }
+  // the mapping used for new mappings, advanced each time bank_counter wraps around so that all banks of all mappings
+  // are tested equally often
+  static int mapping_counter;
   static void set_seed(uint64_t seed);
 
   // a mapping from aggressors included in this pattern to memory addresses (DRAMAddr)
   std::unordered_map<AGGRESSOR_ID_TYPE, DRAMAddr> aggressor_to_addr;
 
-  // the bit flips that were detected while running the pattern with this mapping
-  std::vector<std::vector<BitFlip>> bit_flips;
+  // the bit flips that were detected while running the pattern with this mapping (one range in the FlipStore per
+  // memory check)
+  std::vector<FlipRange> bit_flips;
 
   // the reproducibility score of this mapping, e.g.,
   //    1   => 100%: was reproducible in all reproducibility runs executed,
@@ -89,8 +102,8 @@ class PatternAddressMapper {
 
   void remap_aggressors(DRAMAddr &new_location);
 
-  static std::vector<volatile char *> interleave(
-    std::vector<std::vector<volatile char *>> &patterns, 
+  static PatternIR interleave(
+    std::vector<PatternIR> &patterns, 
     size_t chunk_size, 
     size_t distance,
     size_t count_per_iter
@@ -102,7 +115,7 @@ class PatternAddressMapper {
   std::vector<volatile char*> export_pattern_with_fence_every_nth_access(const HammeringPattern& pattern, int n);
   std::vector<volatile char*> export_pattern_with_fence_per_base_period(const HammeringPattern& pattern, int fences_per_base_period);
 
-  std::vector<volatile char*> export_pattern(const HammeringPattern& pattern, SCHEDULING_POLICY scheduling_policy);
+  PatternIR export_pattern(const HammeringPattern& pattern, SCHEDULING_POLICY scheduling_policy);
 
   [[nodiscard]] const std::string &get_instance_id() const;
 
@@ -123,6 +136,9 @@ class PatternAddressMapper {
 
   void shift_mapping(int rows, const std::unordered_set<AggressorAccessPattern> &aggs_to_move);
 
+  /// moves the aggressors and victims to the same bank and rows in another mapping
+  void move_to_mapping(int new_mapping_id);
+
   [[nodiscard]] size_t count_bitflips() const;
 };
 
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Enums.hpp"
+
+enum class PatternOpType : uint8_t {
+  // load from addr
+  ACCESS,
+  // clflushopt addr
+  FLUSH,
+  // memory barrier (the type is chosen when lowering)
+  FENCE,
+  // synchronize with the next REF; addr is the initial aggressor used for the synchronization
+  SYNC,
+  // continue with the first op of the pattern
+  LOOP_BACK,
+};
+
+struct PatternOp {
+  PatternOpType type;
+  volatile char *addr = nullptr;
+
+  bool operator==(const PatternOp &other) const = default;
+};
+
+// The intermediate representation of a hammering pattern between export (PatternAddressMapper) and JIT (CodeJitter,
+// Jitter). An exported pattern only consists of ACCESS and FENCE ops; make_loop() turns it into the body of a hammering
+// loop by scheduling flushes and fences according to the flushing and fencing strategy and running the optimization
+// passes, so that the JITs only have to translate each op into instructions.
+class PatternIR {
+private:
+  std::vector<PatternOp> ops;
+
+public:
+  PatternIR() = default;
+
+  /// converts a pattern in the legacy format, in which nullptr stands for a fence
+  static PatternIR from_aggressors(const std::vector<volatile char *> &aggressors);
+
+  void access(volatile char *addr) { ops.push_back({PatternOpType::ACCESS, addr}); }
+  void flush(volatile char *addr) { ops.push_back({PatternOpType::FLUSH, addr}); }
+  void fence() { ops.push_back({PatternOpType::FENCE}); }
+  void sync(volatile char *initial_aggressor) { ops.push_back({PatternOpType::SYNC, initial_aggressor}); }
+  void loop_back() { ops.push_back({PatternOpType::LOOP_BACK}); }
+
+  [[nodiscard]] const std::vector<PatternOp> &get_ops() const { return ops; }
+  [[nodiscard]] size_t size() const { return ops.size(); }
+  [[nodiscard]] bool empty() const { return ops.empty(); }
+  [[nodiscard]] std::vector<PatternOp>::const_iterator begin() const { return ops.begin(); }
+  [[nodiscard]] std::vector<PatternOp>::const_iterator end() const { return ops.end(); }
+  const PatternOp &operator[](size_t idx) const { return ops[idx]; }
+
+  /// the number of ACCESS ops
+  [[nodiscard]] size_t num_accesses() const;
+
+  /// the address of the first ACCESS op or nullptr if there is none
+  [[nodiscard]] volatile char *first_access() const;
+
+  /// the address of the last ACCESS op or nullptr if there is none
+  [[nodiscard]] volatile char *last_access() const;
+
+  /// whether both patterns consist of the same sequence of op types, i.e., are lowered to the same instructions
+  [[nodiscard]] bool same_shape(const PatternIR &other) const;
+
+  /// builds the body of a hammering loop from this pattern: flushes and fences are scheduled according to the given
+  /// strategies, followed by a REF synchronization on the bank (and mapping) of the first access and a LOOP_BACK.
+  /// Exits if the pattern has no accesses.
+  [[nodiscard]] PatternIR make_loop(FLUSHING_STRATEGY flushing, FENCING_STRATEGY fencing) const;
+
+  /// inserts flushes according to the flushing strategy (LATEST_POSSIBLE flushes an aggressor right before its row is
+  /// accessed again, EARLIEST_POSSIBLE right after each access, OMIT_FLUSHING once at the end of the pattern) and, for
+  /// FENCING_STRATEGY::LATEST_POSSIBLE, fences before each re-access of a row.
+  void schedule_flushes(FLUSHING_STRATEGY flushing, FENCING_STRATEGY fencing);
+
+  /// removes flushes of addresses that were not accessed since they were last flushed
+  void eliminate_dead_flushes();
+
+  /// merges fences that are not separated by any other op
+  void coalesce_fences();
+};
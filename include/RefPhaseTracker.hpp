@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// The REF prediction published by the RefPhaseTracker, read by the hammering functions jitted with SYNC_MODE::PREDICTED.
+// NOTE: The members of this struct should not be re-arranged, as they are read from Assembly.
+struct alignas(64) RefPrediction {
+  // odd while the tracker updates next_edge and period, a reader retries if it changed while reading them
+  std::atomic<uint64_t> sequence { 0 };
+  // the TSC at which the next REF is expected to be observed, 0 until the tracker is locked
+  std::atomic<uint64_t> next_edge { 0 };
+  // the estimated REF period in TSC cycles, 0 until the tracker is locked
+  std::atomic<uint64_t> period { 0 };
+
+  /// updates edge and period together, only called by the tracker thread
+  void publish(uint64_t edge, uint64_t new_period) {
+    auto seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    next_edge.store(edge, std::memory_order_relaxed);
+    period.store(new_period, std::memory_order_relaxed);
+    sequence.store(seq + 2, std::memory_order_release);
+  }
+};
+
+// Estimates the period and phase of REF in the background, so that the hammering threads can wait for the next REF
+// instead of probing rows until they observe it (see CodeJitter::sync_ref_predicted). A thread pinned to a spare core
+// times accesses to a single row like RefreshTimer::measure; an access slower than the REF threshold marks a REF edge.
+// The period is the median of the first edge distances and then follows the distances of later edges, which compensates
+// for drift between the TSC and the DRAM clock. Once locked, the tracker only probes in a window around each predicted
+// edge to keep its own ACTs low, and the distance between each predicted and observed edge is the sync error.
+class RefPhaseTracker {
+private:
+  RefPrediction prediction;
+
+  volatile char *probe_addr = nullptr;
+  std::atomic<uint64_t> threshold { 0 };
+  int cpu = -1;
+
+  std::thread tracker;
+  std::atomic<bool> stopping { false };
+  std::atomic<bool> locked { false };
+
+  // statistics, only written by the tracker thread
+  std::atomic<size_t> edges { 0 };
+  std::atomic<size_t> missed { 0 };
+  std::atomic<uint64_t> sum_abs_error { 0 };
+  std::atomic<uint64_t> max_abs_error { 0 };
+  std::atomic<size_t> num_errors { 0 };
+
+  RefPhaseTracker() = default;
+
+  void track();
+
+  /// probes until a REF edge is observed (and returns its TSC) or the TSC passed deadline (and returns 0)
+  uint64_t probe_until(uint64_t deadline);
+
+public:
+  // the number of edge distances the initial period is estimated from
+  static constexpr size_t BOOTSTRAP_EDGES = 33;
+  // lose the lock after this many consecutive edges were not observed in their window
+  static constexpr size_t MAX_CONSECUTIVE_MISSES = 8;
+  // the time to wait for the initial period estimate, which takes BOOTSTRAP_EDGES tREFI (i.e., well below 1 ms)
+  static constexpr size_t START_TIMEOUT_MS = 500;
+
+  static RefPhaseTracker &get();
+
+  RefPhaseTracker(const RefPhaseTracker &) = delete;
+  RefPhaseTracker &operator=(const RefPhaseTracker &) = delete;
+
+  ~RefPhaseTracker();
+
+  /// starts tracking REF on the given cpu by timing accesses to probe_addr against the raw REF threshold (see
+  /// RefreshTimer::get_raw_refresh_threshold) and waits until the period was estimated; stops the tracker and returns
+  /// false if that takes longer than START_TIMEOUT_MS
+  bool start(int cpu, volatile char *probe_addr, uint64_t threshold);
+
+  void stop();
+
+  /// uses a new raw REF threshold, e.g., after the RefreshTimer was recalibrated
+  void set_threshold(uint64_t value) { threshold = value; }
+
+  [[nodiscard]] bool is_running() const { return tracker.joinable(); }
+
+  [[nodiscard]] bool is_locked() const { return locked.load(std::memory_order_acquire); }
+
+  /// the shared cache line the prediction is published in, its address does not change
+  [[nodiscard]] const RefPrediction &get_prediction() const { return prediction; }
+
+  /// the number of REF edges observed and predicted edges that were not observed in their window
+  [[nodiscard]] size_t get_edges() const { return edges; }
+  [[nodiscard]] size_t get_missed() const { return missed; }
+
+  /// the mean and maximum distance between predicted and observed REF edges in TSC cycles
+  [[nodiscard]] double get_mean_sync_error() const;
+  [[nodiscard]] uint64_t get_max_sync_error() const { return max_abs_error; }
+
+  /// resets the statistics
+  void reset_stats();
+};
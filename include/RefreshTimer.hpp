@@ -4,28 +4,46 @@
 #include <emmintrin.h>
 #include <vector>
 #include <x86intrin.h>
+#include "TimingStats.hpp"
 
 typedef struct {
   uint64_t timing;
   uint64_t timestamp;
 } measurement;
 
+// the result of one round of the REF timing analysis
+struct RefreshAnalysis {
+  uint64_t threshold;
+  uint64_t cycles_per_refresh;
+  size_t num_peaks;
+};
+
 class RefreshTimer {
   private:
     volatile char *measurement_addr;
     uint64_t refresh_threshold;
     uint64_t cycles_per_refresh;
-    double_t get_average(std::vector<uint64_t> &measurements);
-    uint64_t get_median(std::vector<uint64_t> &measurements);
-    std::vector<measurement> get_measurements(size_t n);
+    // the samples of the last call to get_measurements and scratch space (and the histogram) for their analysis,
+    // allocated once
+    SampleBuffer timings;
+    SampleBuffer timestamps;
+    SampleBuffer scratch;
+    SampleBuffer peak_timings;
+    SampleBuffer peak_timestamps;
+    Histogram histogram;
+    void get_measurements(size_t n);
+    RefreshAnalysis analyze(size_t n);
     measurement measure(volatile char *addr);
-    std::vector<uint64_t> extract_timestamps(std::vector<measurement> &measurements);
-    std::vector<uint64_t> extract_timings(std::vector<measurement> &measurements);
   public:
     RefreshTimer(volatile char *measurement_addr);
+    // uses a previously measured threshold instead of analyzing the REF timing again
+    RefreshTimer(volatile char *measurement_addr, uint64_t refresh_threshold, uint64_t cycles_per_refresh);
     uint64_t get_refresh_threshold();
+    uint64_t get_raw_refresh_threshold();
     uint64_t get_cycles_per_refresh();
     uint64_t reanalyze();
+    void recalibrate();
+    bool drifted(size_t n = 50000);
     uint64_t wait_for_refresh(size_t bank);
     static uint64_t current_timestamp();
 };
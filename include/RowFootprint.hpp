@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "DRAMAddr.hpp"
+#include "DRAMConfig.hpp"
+#include "GlobalDefines.hpp"
+
+// Enumerates the virtual addresses of all cache lines that belong to a single DRAM row (bank, row).
+// Due to the XOR functions of the address matrix, these lines are generally not contiguous in the virtual address
+// space. As the matrix is linear over GF(2), the address of column c is the address of column 0 XORed with the
+// contribution of c's bits. That contribution is precomputed for each column bit above the cache line offset.
+class RowFootprint {
+private:
+  // the address of column 0 of the row
+  uintptr_t row_base;
+
+  // the address bits toggled by each column bit that selects a cache line (i.e., column bit log2(CACHELINE_SIZE)+i)
+  std::vector<uintptr_t> line_basis;
+
+  size_t num_lines;
+
+public:
+  explicit RowFootprint(const DRAMAddr &row_addr) {
+    auto &config = DRAMConfig::get();
+    row_base = (uintptr_t) DRAMAddr(row_addr.bank, row_addr.row, 0, row_addr.mapping_id).to_virt();
+
+    // the lowest column bits address the bytes within a cache line, all other bits select the line
+    const size_t offset_bits = __builtin_ctzll(CACHELINE_SIZE);
+    for (size_t bit = offset_bits; bit < config.column_bits(); bit++) {
+      line_basis.push_back(config.apply_addr_matrix(config.linearize_dram_addr(0, 0, 1ULL << bit)));
+    }
+    num_lines = 1ULL << line_basis.size();
+  }
+
+  /// the number of cache lines in the row.
+  [[nodiscard]] size_t size() const {
+    return num_lines;
+  }
+
+  /// the virtual address of the idx-th cache line (in column order) of the row.
+  [[nodiscard]] volatile char *line(size_t idx) const {
+    uintptr_t addr = row_base;
+    for (size_t bit = 0; bit < line_basis.size(); bit++) {
+      if (idx & (1ULL << bit)) addr ^= line_basis[bit];
+    }
+    return (volatile char *) addr;
+  }
+
+  class iterator {
+  private:
+    const RowFootprint *footprint;
+    size_t idx;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = volatile char *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = volatile char *;
+
+    iterator(const RowFootprint *footprint, size_t idx) : footprint(footprint), idx(idx) {}
+
+    volatile char *operator*() const { return footprint->line(idx); }
+
+    iterator &operator++() {
+      idx++;
+      return *this;
+    }
+
+    bool operator==(const iterator &other) const { return idx == other.idx; }
+
+    bool operator!=(const iterator &other) const { return idx != other.idx; }
+  };
+
+  [[nodiscard]] iterator begin() const {
+    return {this, 0};
+  }
+
+  [[nodiscard]] iterator end() const {
+    return {this, num_lines};
+  }
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+
+// Non-temporal (streaming) stores that bypass the cache hierarchy.
+// Used to write large amounts of data that will not be read again soon (e.g., initializing the allocation) without
+// evicting useful cache lines or paying for read-for-ownership traffic.
+class StreamStore {
+public:
+  /// copies len bytes from src to dst using streaming stores; dst and src must be aligned to 64 bytes. The stores are
+  /// weakly ordered, callers need to issue an sfence before other threads may rely on the data.
+  static void copy(volatile void *dst, const void *src, size_t len);
+};
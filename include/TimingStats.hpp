@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Samples of a timing measurement (e.g., TSC deltas) in a buffer that is allocated once. clear() only resets the
+// number of samples, hence repeated measurements (see RefreshTimer::reanalyze) do not allocate and use bounded memory.
+class SampleBuffer {
+private:
+  std::vector<uint64_t> samples;
+  size_t count = 0;
+
+public:
+  explicit SampleBuffer(size_t capacity) : samples(capacity) {}
+
+  void clear() { count = 0; }
+
+  /// appends a sample, returns false (and drops it) if the buffer is full
+  bool push(uint64_t sample) {
+    if (count == samples.size()) return false;
+    samples[count++] = sample;
+    return true;
+  }
+
+  /// sets the number of samples after they were written through data(); n must not exceed the capacity
+  void resize(size_t n) { count = n; }
+
+  [[nodiscard]] size_t size() const { return count; }
+  [[nodiscard]] size_t capacity() const { return samples.size(); }
+  [[nodiscard]] bool empty() const { return count == 0; }
+  [[nodiscard]] bool full() const { return count == samples.size(); }
+
+  uint64_t *data() { return samples.data(); }
+  [[nodiscard]] const uint64_t *data() const { return samples.data(); }
+  uint64_t &operator[](size_t idx) { return samples[idx]; }
+  const uint64_t &operator[](size_t idx) const { return samples[idx]; }
+  uint64_t *begin() { return samples.data(); }
+  uint64_t *end() { return samples.data() + count; }
+  [[nodiscard]] const uint64_t *begin() const { return samples.data(); }
+  [[nodiscard]] const uint64_t *end() const { return samples.data() + count; }
+};
+
+// A histogram over the values [0, max_value) that is filled while measuring instead of storing every sample; values
+// beyond the range (e.g., measurements that were interrupted) are counted as rejected.
+class Histogram {
+private:
+  std::vector<size_t> bins;
+  size_t total = 0;
+  size_t rejected = 0;
+
+public:
+  explicit Histogram(size_t max_value) : bins(max_value, 0) {}
+
+  /// adds a value, returns false if it is out of range
+  bool add(uint64_t value) {
+    if (value >= bins.size()) {
+      rejected++;
+      return false;
+    }
+    bins[value]++;
+    total++;
+    return true;
+  }
+
+  void clear();
+
+  [[nodiscard]] size_t size() const { return total; }
+  [[nodiscard]] size_t get_rejected() const { return rejected; }
+
+  /// the smallest value v such that at least q * size() values are <= v
+  [[nodiscard]] uint64_t quantile(double q) const;
+
+  /// the largest value v such that at least n values are >= v
+  [[nodiscard]] uint64_t top(size_t n) const;
+};
+
+// Reductions and order statistics over timing samples. The reductions are vectorized (AVX-512 or AVX2 if available)
+// and compiled with optimizations even in -O0 builds; the order statistics run in linear time using std::nth_element.
+class TimingStats {
+public:
+  static uint64_t sum(const uint64_t *samples, size_t n);
+
+  static double mean(const uint64_t *samples, size_t n) { return n == 0 ? 0 : (double) sum(samples, n) / n; }
+
+  static uint64_t max(const uint64_t *samples, size_t n);
+
+  /// the number of samples greater than threshold
+  static size_t count_above(const uint64_t *samples, size_t n, uint64_t threshold);
+
+  /// the q-quantile (0 <= q <= 1) of n > 0 samples; reorders the samples
+  static uint64_t quantile(uint64_t *samples, size_t n, double q);
+
+  static uint64_t median(uint64_t *samples, size_t n) { return quantile(samples, n, 0.5); }
+
+  /// removes all samples greater than limit while keeping the order of the others, returns the new number of samples
+  static size_t reject_above(uint64_t *samples, size_t n, uint64_t limit);
+
+  /// the root of the mean squared distance of the samples above mean, divided by all n samples
+  static double upper_semideviation(const uint64_t *samples, size_t n, double mean);
+};
@@ -0,0 +1,213 @@
+#include "CalibrationProfile.hpp"
+#include "DramAnalyzer.hpp"
+#include "RefreshTimer.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#define SMBIOS_MEMORY_DEVICES "/sys/firmware/dmi/entries/17-"
+
+// offsets into an SMBIOS memory device (type 17) structure
+#define SMBIOS_MEMORY_DEVICE_SIZE 0x0C
+#define SMBIOS_MEMORY_DEVICE_MANUFACTURER 0x17
+#define SMBIOS_MEMORY_DEVICE_SERIAL 0x18
+#define SMBIOS_MEMORY_DEVICE_PART 0x1A
+
+std::string CalibrationProfile::read_cpu_model() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.rfind("model name", 0) == 0) {
+      auto colon = line.find(':');
+      if (colon != std::string::npos && colon + 2 <= line.size()) {
+        return line.substr(colon + 2);
+      }
+    }
+  }
+  return UNKNOWN;
+}
+
+// the strings of an SMBIOS structure follow its formatted area, each terminated by a NUL, and are referenced by their
+// 1-based index
+static std::string smbios_string(const std::vector<uint8_t> &raw, size_t offset) {
+  if (offset >= raw[1] || raw[offset] == 0) {
+    return "";
+  }
+  size_t pos = raw[1];
+  for (int idx = 1; pos < raw.size() && raw[pos] != 0; idx++) {
+    size_t end = pos;
+    while (end < raw.size() && raw[end] != 0) end++;
+    if (idx == raw[offset]) {
+      return std::string(raw.begin() + pos, raw.begin() + end);
+    }
+    pos = end + 1;
+  }
+  return "";
+}
+
+std::string CalibrationProfile::read_dimm_id() {
+  std::string id;
+  for (int i = 0; std::filesystem::exists(SMBIOS_MEMORY_DEVICES + std::to_string(i)); i++) {
+    std::ifstream f(SMBIOS_MEMORY_DEVICES + std::to_string(i) + "/raw", std::ios::binary);
+    std::vector<uint8_t> raw((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    if (raw.size() <= SMBIOS_MEMORY_DEVICE_PART || raw[1] <= SMBIOS_MEMORY_DEVICE_PART) {
+      continue;
+    }
+    // a size of 0 marks an empty slot
+    if (raw[SMBIOS_MEMORY_DEVICE_SIZE] == 0 && raw[SMBIOS_MEMORY_DEVICE_SIZE + 1] == 0) {
+      continue;
+    }
+    if (!id.empty()) {
+      id += "; ";
+    }
+    id += smbios_string(raw, SMBIOS_MEMORY_DEVICE_MANUFACTURER) + " " + smbios_string(raw, SMBIOS_MEMORY_DEVICE_PART) + " "
+        + smbios_string(raw, SMBIOS_MEMORY_DEVICE_SERIAL);
+  }
+  // the SMBIOS entries are only readable by root
+  return id.empty() ? UNKNOWN : id;
+}
+
+CalibrationProfile CalibrationProfile::load_or_measure(const std::string &path, volatile char *start, bool recalibrate) {
+  CalibrationProfile current;
+  current.cpu_model = read_cpu_model();
+  current.dimm_id = read_dimm_id();
+
+  // matrix cells change the working directory
+  auto absolute = std::filesystem::absolute(path).string();
+
+  CalibrationProfile stored;
+  if (!recalibrate && load(absolute, stored)) {
+    if (stored.same_machine(current)) {
+      printf("using the calibration profile stored in %s: REF threshold %lu, %lu cycles per REF, bank conflict threshold %lu, "
+             "%lu ACTs per tREFI.\n", absolute.c_str(), stored.refresh_threshold, stored.cycles_per_refresh,
+             stored.bank_conflict_threshold, stored.acts_per_trefi);
+      stored.path = absolute;
+      return stored;
+    }
+    if (current.dimm_id == UNKNOWN || stored.dimm_id == UNKNOWN) {
+      printf("the installed DIMMs cannot be identified (the SMBIOS entries are only readable by root), "
+             "not using the calibration profile in %s.\n", absolute.c_str());
+    } else {
+      printf("the calibration profile in %s belongs to another machine (%s, %s), calibrating again.\n", absolute.c_str(),
+             stored.cpu_model.c_str(), stored.dimm_id.c_str());
+    }
+  }
+
+  auto profile = measure(start);
+  profile.cpu_model = current.cpu_model;
+  profile.dimm_id = current.dimm_id;
+  profile.path = absolute;
+  profile.save();
+  return profile;
+}
+
+CalibrationProfile CalibrationProfile::measure(volatile char *start) {
+  printf("calibrating...\n");
+  CalibrationProfile profile;
+
+  RefreshTimer timer(start);
+  profile.refresh_threshold = timer.get_raw_refresh_threshold();
+  profile.cycles_per_refresh = timer.get_cycles_per_refresh();
+
+  DramAnalyzer analyzer(start);
+  analyzer.find_threshold();
+  analyzer.find_bank_conflicts();
+  profile.bank_conflict_threshold = analyzer.get_threshold();
+  profile.acts_per_trefi = analyzer.count_acts_per_trefi();
+
+  printf("calibrated: REF threshold %lu, %lu cycles per REF, bank conflict threshold %lu, %lu ACTs per tREFI.\n",
+         profile.refresh_threshold, profile.cycles_per_refresh, profile.bank_conflict_threshold, profile.acts_per_trefi);
+  return profile;
+}
+
+bool CalibrationProfile::load(const std::string &path, CalibrationProfile &profile) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  // one "<key> <value>" per line, the value extends to the end of the line
+  std::string line;
+  try {
+    while (std::getline(file, line)) {
+      auto space = line.find(' ');
+      if (space == std::string::npos) {
+        continue;
+      }
+      auto key = line.substr(0, space);
+      auto value = line.substr(space + 1);
+      if (key == "cpu_model") {
+        profile.cpu_model = value;
+      } else if (key == "dimm_id") {
+        profile.dimm_id = value;
+      } else if (key == "refresh_threshold") {
+        profile.refresh_threshold = std::stoul(value);
+      } else if (key == "cycles_per_refresh") {
+        profile.cycles_per_refresh = std::stoul(value);
+      } else if (key == "bank_conflict_threshold") {
+        profile.bank_conflict_threshold = std::stoul(value);
+      } else if (key == "acts_per_trefi") {
+        profile.acts_per_trefi = std::stoul(value);
+      } else if (key == "bank_acts_per_trefi") {
+        // "<threads> <placement> <acts of bank 0> <acts of bank 1> ..."
+        std::istringstream values(value);
+        size_t threads;
+        std::string placement;
+        uint64_t acts;
+        // profiles from before the placement was recorded are measured again
+        if (!(values >> threads >> placement) || std::isdigit((unsigned char) placement[0])) {
+          continue;
+        }
+        auto &banks = profile.bank_acts_per_trefi[{threads, placement}];
+        while (values >> acts) {
+          banks.push_back(acts);
+        }
+      }
+    }
+  } catch (const std::logic_error &e) {
+    // std::stoul throws std::invalid_argument or std::out_of_range on a truncated or corrupt file
+    printf("could not parse the calibration profile in %s (%s), calibrating again.\n", path.c_str(), e.what());
+    return false;
+  }
+  return !profile.cpu_model.empty() && !profile.dimm_id.empty() && profile.refresh_threshold != 0
+      && profile.bank_conflict_threshold != 0 && profile.acts_per_trefi != 0;
+}
+
+void CalibrationProfile::save() const {
+  if (path.empty()) {
+    return;
+  }
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    printf("could not store the calibration profile in %s.\n", path.c_str());
+    return;
+  }
+  file << "cpu_model " << cpu_model << "\n"
+       << "dimm_id " << dimm_id << "\n"
+       << "refresh_threshold " << refresh_threshold << "\n"
+       << "cycles_per_refresh " << cycles_per_refresh << "\n"
+       << "bank_conflict_threshold " << bank_conflict_threshold << "\n"
+       << "acts_per_trefi " << acts_per_trefi << "\n";
+  for (const auto &[key, banks] : bank_acts_per_trefi) {
+    file << "bank_acts_per_trefi " << key.first << " " << key.second;
+    for (auto acts : banks) {
+      file << " " << acts;
+    }
+    file << "\n";
+  }
+  printf("stored the calibration profile in %s.\n", path.c_str());
+}
+
+bool CalibrationProfile::same_machine(const CalibrationProfile &other) const {
+  // without the DIMM ids, a profile could have been measured with any DIMMs in a machine with the same CPU
+  if (cpu_model == UNKNOWN || dimm_id == UNKNOWN || other.dimm_id == UNKNOWN) {
+    return false;
+  }
+  return cpu_model == other.cpu_model && dimm_id == other.dimm_id;
+}
@@ -1,9 +1,17 @@
 #include "CodeJitter.hpp"
 #include "Enums.hpp"
 #include "GlobalDefines.hpp"
+#include "JitRuntimePool.hpp"
+#include "PatternIR.hpp"
+#include "RefPhaseTracker.hpp"
 #include "asmjit/core/globals.h"
 #include "asmjit/x86/x86assembler.h"
+#include <climits>
 #include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <unordered_map>
 
 CodeJitter::CodeJitter()
     : pattern_sync_each_ref(false),
@@ -11,7 +19,6 @@ CodeJitter::CodeJitter()
       fencing_strategy(FENCING_STRATEGY::OMIT_FENCING),
       total_activations(5000000),
       num_aggs_for_sync(2) {
-  logger = new asmjit::StringLogger;
 }
 
 CodeJitter::~CodeJitter() {
@@ -19,21 +26,38 @@ CodeJitter::~CodeJitter() {
 }
 
 void CodeJitter::cleanup() {
+  release_relocatable();
+  if (cached_fn != nullptr) {
+    // the function stays in the cache for the next instance jitting the same pattern
+    cached_fn.reset();
+    fn = nullptr;
+  }
   if (fn!=nullptr) {
-    runtime.release(fn);
+    runtime->release(fn);
     fn = nullptr;
   }
   if (fn_ref_sync != nullptr) {
-    runtime.release(fn_ref_sync);
+    runtime->release(fn_ref_sync);
     fn_ref_sync = nullptr;
   }
   if (logger!=nullptr) {
     delete logger;
     logger = nullptr;
   }
+  // all functions are released, hence the runtime can be handed to another instance
+  JitRuntimePool::get().release(runtime);
+  runtime = nullptr;
+}
+
+asmjit::JitRuntime &CodeJitter::get_runtime() {
+  if (runtime == nullptr) {
+    runtime = JitRuntimePool::get().acquire();
+  }
+  return *runtime;
 }
 
-int CodeJitter::hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool verbose, bool print_act_data) {
+int CodeJitter::hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool verbose, bool print_act_data,
+                               HammeringData *hammering_data) {
   if (fn==nullptr) {
     Logger::log_error("Skipping hammering pattern as pattern could not be created successfully.");
     return -1;
@@ -41,10 +65,11 @@ int CodeJitter::hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool ver
   HammeringData data {};
   if (verbose) Logger::log_info("Hammering the last generated pattern.");
   int total_sync_acts = fn(&data);
+  if (hammering_data != nullptr) *hammering_data = data;
 
   if (verbose) {
     Logger::log_info("Synchronization stats:");
-    Logger::log_data(format_string("Total sync acts: %d", total_sync_acts));
+    Logger::logf(LogLevel::DATA, "Total sync acts: %d", total_sync_acts);
 
     const auto total_acts_pattern = fuzzing_parameters.get_total_acts_pattern();
     auto pattern_rounds = fuzzing_parameters.get_hammering_total_num_activations()/total_acts_pattern;
@@ -56,14 +81,14 @@ int CodeJitter::hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool ver
                                   // pattern here (=1) as this is the sync that is repeated after each hammering run
                                   : 1;
     auto num_synced_refs = pattern_rounds*acts_per_pattern_round;
-    Logger::log_data(format_string("Number of pattern reps while hammering: %d", pattern_rounds));
-    Logger::log_data(format_string("Number of total synced REFs (est.): %d", num_synced_refs));
-    Logger::log_data(format_string("Avg. number of acts per sync: %d", total_sync_acts/num_synced_refs));
+    Logger::logf(LogLevel::DATA, "Number of pattern reps while hammering: %d", pattern_rounds);
+    Logger::logf(LogLevel::DATA, "Number of total synced REFs (est.): %d", num_synced_refs);
+    Logger::logf(LogLevel::DATA, "Avg. number of acts per sync: %d", total_sync_acts/num_synced_refs);
   }
 
   if (print_act_data) {
     // Print total ACTs + TSC delta.
-    Logger::log_data(format_string("ACT DATA: %llu ACTs, %llu cycles", data.total_acts, data.tsc_delta));
+    Logger::logf(LogLevel::DATA, "ACT DATA: %llu ACTs, %llu cycles", data.total_acts, data.tsc_delta);
   }
 
   return total_sync_acts;
@@ -72,7 +97,7 @@ int CodeJitter::hammer_pattern(FuzzingParameterSet &fuzzing_parameters, bool ver
 void CodeJitter::jit_strict(
   FLUSHING_STRATEGY flushing,
   FENCING_STRATEGY fencing,
-  const std::vector<volatile char *> &aggressor_pairs,
+  const PatternIR &pattern,
   FENCE_TYPE fence_type,
   int total_num_activations
 ) {
@@ -87,16 +112,210 @@ void CodeJitter::jit_strict(
   this->num_aggs_for_sync = 2;
 
 
-  // some sanity checks
-  if (fn!=nullptr) {
+  // some sanity checks (functions taken from the cache or relocatable functions can be replaced without leaking them)
+  if (fn!=nullptr && cached_fn==nullptr && !(relocatable && reloc_code!=nullptr)) {
     Logger::log_error(
         "Function pointer is not NULL, cannot continue jitting code without leaking memory. Did you forget to call cleanup() before?");
     exit(1);
   }
 
+  // relocatable functions are patched in place and hence cannot be shared through the cache
+  if (relocatable) {
+    jit_relocatable(flushing, fencing, pattern, fence_type, total_num_activations);
+    return;
+  }
+
+  JitCacheKey key {
+    pattern.get_ops(),
+    flushing,
+    fencing,
+    fence_type,
+    total_num_activations,
+    DRAMConfig::get().get_sync_ref_threshold(),
+    emitter,
+    sync_mode
+  };
+
+  // the function may already have been jitted ahead of time (see FuzzPipeline)
+  if (cached_fn != nullptr && key == cached_key) {
+    return;
+  }
+
+  // drop the function jitted for other inputs, it stays in the cache
+  if (cached_fn != nullptr) {
+    cached_fn.reset();
+    fn = nullptr;
+  }
+
+  cached_fn = JitCache::get().lookup(key);
+  if (cached_fn != nullptr) {
+    fn = cached_fn->fn;
+    code_size = cached_fn->code_size;
+    cached_key = std::move(key);
+    return;
+  }
+
+  asmjit::CodeHolder code;
+  code.init(JitCache::get().get_runtime().environment());
+  if (log_assembly) {
+    if (logger == nullptr) logger = new asmjit::StringLogger;
+    code.setLogger(logger);
+  }
+  assemble_hammer_fn(code, pattern.make_loop(flushing, fencing), fence_type, total_num_activations, nullptr);
+
+  // add the generated code to the cache's runtime.
+  cached_fn = JitCache::get().insert(key, code);
+  fn = cached_fn->fn;
+  code_size = cached_fn->code_size;
+  cached_key = std::move(key);
+
+  // uncomment the following line to see the jitted ASM code
+  // printf("[DEBUG] asmjit logger content:\n%s\n", logger->corrupted_data());
+}
+
+void CodeJitter::jit_relocatable(
+  FLUSHING_STRATEGY flushing,
+  FENCING_STRATEGY fencing,
+  const PatternIR &pattern,
+  FENCE_TYPE fence_type,
+  int total_num_activations
+) {
+  auto loop = pattern.make_loop(flushing, fencing);
+  const auto sync_ref_threshold = DRAMConfig::get().get_sync_ref_threshold();
+  if (reloc_code != nullptr) {
+    const bool same_params = reloc_flushing == flushing && reloc_fencing == fencing && reloc_fence_type == fence_type
+        && reloc_total_activations == total_num_activations && reloc_sync_ref_threshold == sync_ref_threshold
+        && reloc_sync_mode == sync_mode;
+    // the function may already have been jitted ahead of time (see FuzzPipeline)
+    if (same_params && loop.get_ops() == reloc_loop.get_ops()) {
+      fn = (int (*)(HammeringData *)) reloc_code;
+      return;
+    }
+    if (same_params && relocate(loop)) {
+      fn = (int (*)(HammeringData *)) reloc_code;
+      code_size = reloc_code_size;
+      num_relocations++;
+      return;
+    }
+    release_relocatable();
+  }
+
   asmjit::CodeHolder code;
-  code.init(runtime.environment());
-  code.setLogger(logger);
+  code.init(get_runtime().environment());
+  if (log_assembly) {
+    if (logger == nullptr) logger = new asmjit::StringLogger;
+    code.setLogger(logger);
+  }
+  AddressImmediates immediates;
+  assemble_hammer_fn(code, loop, fence_type, total_num_activations, &immediates);
+
+  // the function lives in pages owned by this instance (instead of the runtime's shared blocks) so that they can be
+  // made writable for patching without affecting any other jitted function
+  if (code.flatten() || code.resolveUnresolvedLinks()) {
+    throw std::runtime_error("[-] Error occurred while jitting code. Aborting execution!");
+  }
+  const auto pagesize = static_cast<size_t>(getpagesize());
+  reloc_size = ((code.codeSize() + pagesize - 1)/pagesize)*pagesize;
+  void *mem = mmap(nullptr, reloc_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    perror("mmap");
+    exit(EXIT_FAILURE);
+  }
+  reloc_code = (uint8_t *) mem;
+  code_size = reloc_code_size = code.codeSize();
+  if (code.relocateToBase((uint64_t) reloc_code)
+      || code.copyFlattenedData(reloc_code, reloc_size, asmjit::CopySectionFlags::kPadTargetBuffer)) {
+    throw std::runtime_error("[-] Error occurred while jitting code. Aborting execution!");
+  }
+  if (mprotect(reloc_code, reloc_size, PROT_READ | PROT_EXEC) != 0) {
+    perror("mprotect");
+    exit(EXIT_FAILURE);
+  }
+
+  reloc_immediates = std::move(immediates);
+  reloc_loop = std::move(loop);
+  reloc_flushing = flushing;
+  reloc_fencing = fencing;
+  reloc_fence_type = fence_type;
+  reloc_total_activations = total_num_activations;
+  reloc_sync_ref_threshold = sync_ref_threshold;
+  reloc_sync_mode = sync_mode;
+  fn = (int (*)(HammeringData *)) reloc_code;
+  num_assemblies++;
+}
+
+bool CodeJitter::relocate(const PatternIR &loop) {
+  // the code can only be reused if the new pattern results in exactly the same instructions
+  if (!loop.same_shape(reloc_loop)) {
+    return false;
+  }
+
+  // map each address encoded in the function to its new value
+  std::unordered_map<uint64_t, uint64_t> new_address;
+  auto add_mapping = [&new_address](volatile char *from, volatile char *to) {
+    auto it = new_address.emplace((uint64_t) from, (uint64_t) to).first;
+    return it->second == (uint64_t) to;
+  };
+  for (size_t i = 0; i < loop.size(); i++) {
+    const auto &old_op = reloc_loop[i];
+    const auto &new_op = loop[i];
+    // PREDICTED also encodes the sync rows, for its fallback to probing
+    if (old_op.type == PatternOpType::SYNC) {
+      auto old_sync_rows = sync_ref_addresses(DRAMAddr((void *) old_op.addr));
+      auto new_sync_rows = sync_ref_addresses(DRAMAddr((void *) new_op.addr));
+      for (size_t j = 0; j < old_sync_rows.size(); j++) {
+        if (!add_mapping(old_sync_rows[j], new_sync_rows[j])) return false;
+      }
+    } else if (old_op.type == PatternOpType::ACCESS || old_op.type == PatternOpType::FLUSH) {
+      if (!add_mapping(old_op.addr, new_op.addr)) return false;
+    }
+  }
+
+  AddressImmediates patched = reloc_immediates;
+  for (auto &[offset, addr] : patched) {
+    auto it = new_address.find(addr);
+    if (it == new_address.end()) return false;
+    addr = it->second;
+  }
+
+  if (mprotect(reloc_code, reloc_size, PROT_READ | PROT_WRITE) != 0) {
+    perror("mprotect");
+    exit(EXIT_FAILURE);
+  }
+  for (const auto &[offset, addr] : patched) {
+    memcpy(reloc_code + offset, &addr, sizeof(addr));
+  }
+  if (mprotect(reloc_code, reloc_size, PROT_READ | PROT_EXEC) != 0) {
+    perror("mprotect");
+    exit(EXIT_FAILURE);
+  }
+
+  reloc_immediates = std::move(patched);
+  reloc_loop = loop;
+  return true;
+}
+
+void CodeJitter::release_relocatable() {
+  if (reloc_code == nullptr) {
+    return;
+  }
+  if (fn == (int (*)(HammeringData *)) reloc_code) {
+    fn = nullptr;
+  }
+  munmap(reloc_code, reloc_size);
+  reloc_code = nullptr;
+  reloc_size = 0;
+  reloc_immediates.clear();
+  reloc_loop = PatternIR();
+}
+
+void CodeJitter::assemble_hammer_fn(
+  asmjit::CodeHolder &code,
+  const PatternIR &loop,
+  FENCE_TYPE fence_type,
+  int total_num_activations,
+  AddressImmediates *immediates
+) {
   asmjit::x86::Assembler a(&code);
 
   asmjit::Label for_begin = a.newLabel();
@@ -115,12 +334,18 @@ void CodeJitter::jit_strict(
 
   // ------- part 1: synchronize with the beginning of an interval ---------------------------
 
-  // Get the inital aggressor for sync_ref_nonrepeating().
-  auto hammer_bank = DRAMAddr((void*)aggressor_pairs.front()).bank;
-  auto sync_bank = hammer_bank;
-  auto sync_ref_initial_aggr = DRAMAddr(sync_bank, 0, 0);
-
-  sync_ref_nonrepeating(sync_ref_initial_aggr, DRAMConfig::get().get_sync_ref_threshold(), a);
+  // The loop ends with a synchronization, the same rows are used to synchronize with the first interval.
+  const auto sync_ref_threshold = DRAMConfig::get().get_sync_ref_threshold();
+  for (const auto &op : loop) {
+    if (op.type == PatternOpType::SYNC) {
+      if (sync_mode == SYNC_MODE::PREDICTED) {
+        sync_ref_predicted(DRAMAddr((void *) op.addr), sync_ref_threshold, a, immediates);
+      } else {
+        sync_ref_nonrepeating(DRAMAddr((void *) op.addr), sync_ref_threshold, a, immediates);
+      }
+      break;
+    }
+  }
 
   // ------- part 2: perform hammering ---------------------------------------------------------------------------------
 
@@ -136,16 +361,26 @@ void CodeJitter::jit_strict(
   a.mov(asmjit::x86::rsi, total_num_activations);
   a.mov(asmjit::x86::edx, 0);  // num activations counter
 
-  a.bind(for_begin);
-  a.cmp(asmjit::x86::rsi, 0);
-  a.jle(for_end);
-
-  // a map to keep track of aggressors that have been accessed before and need a fence before their next access
-  std::unordered_map<size_t, bool> accessed_before;
+  // The compact emitter addresses all aggressors relative to %r15 (which is not used by sync_ref_nonrepeating).
+  // Relocatable functions need every address as a separate immediate, hence they are always unrolled.
+  const bool compact = emitter == JIT_EMITTER::COMPACT && immediates == nullptr;
+  const uint64_t base = (uint64_t) loop.first_access();
+  if (compact) {
+    a.mov(asmjit::x86::r15, base);
+  }
 
-  size_t cnt_total_activations = 0;
-  asmjit::Error (*fence_fn) (asmjit::x86::Assembler&);
+  // returns the memory operand for addr, loading addr into %rax first if it cannot be encoded relative to %r15
+  auto operand = [&](uint64_t addr) {
+    auto disp = (int64_t) (addr - base);
+    if (compact && disp >= INT32_MIN && disp <= INT32_MAX) {
+      return asmjit::x86::ptr(asmjit::x86::r15, (int32_t) disp);
+    }
+    emit_address(a, addr, immediates);
+    return asmjit::x86::ptr(asmjit::x86::rax);
+  };
 
+  // NO_FENCE drops all fences of the pattern
+  asmjit::Error (*fence_fn) (asmjit::x86::Assembler&) = [](asmjit::x86::Assembler &){ return asmjit::Error(asmjit::kErrorOk); };
   if (fence_type == MFENCE) {
     fence_fn = [](asmjit::x86::Assembler &as){ return as.mfence(); };
   } else if (fence_type == LFENCE) {
@@ -154,62 +389,45 @@ void CodeJitter::jit_strict(
     fence_fn = [](asmjit::x86::Assembler &as){ return as.sfence(); };
   }
 
-  // hammer each aggressor once
-  for (auto* aggr : aggressor_pairs) {
-    if (aggr == nullptr) {
-      fence_fn(a);
-      continue;
-    }
+  a.bind(for_begin);
+  a.cmp(asmjit::x86::rsi, 0);
+  a.jle(for_end);
 
-    auto row = DRAMAddr((void *)aggr).actual_row();
-    auto cur_addr = (uint64_t)aggr;
-    if (accessed_before[row]) {
-      // flush
-      if (flushing==FLUSHING_STRATEGY::LATEST_POSSIBLE) {
-        a.mov(asmjit::x86::rax, cur_addr);
-        a.clflushopt(asmjit::x86::ptr(asmjit::x86::rax));
-        accessed_before[row] = false;
-      }
-      // fence to ensure flushing finished and defined order of aggressors is guaranteed
-      if (fencing==FENCING_STRATEGY::LATEST_POSSIBLE) {
+  const auto num_accesses = loop.num_accesses();
+  for (const auto &op : loop) {
+    switch (op.type) {
+      case PatternOpType::ACCESS:
+        a.mov(asmjit::x86::rcx, operand((uint64_t) op.addr));
+        if (!compact) {
+          a.dec(asmjit::x86::rsi);
+          a.inc(asmjit::x86::edx);
+        }
+        break;
+      case PatternOpType::FLUSH:
+        a.clflushopt(operand((uint64_t) op.addr));
+        break;
+      case PatternOpType::FENCE:
         fence_fn(a);
-        accessed_before[row] = false;
-      }
+        break;
+      case PatternOpType::SYNC:
+        // the counters are only read at the beginning of the loop, so they can be updated once per round (before
+        // sync_ref_nonrepeating adds its ACTs to %edx)
+        if (compact) {
+          a.sub(asmjit::x86::rsi, num_accesses);
+          a.add(asmjit::x86::edx, num_accesses);
+        }
+        // ------- part 3: synchronize with the end  ---------------------------------------------------------------
+        if (sync_mode == SYNC_MODE::PREDICTED) {
+          sync_ref_predicted(DRAMAddr((void *) op.addr), sync_ref_threshold, a, immediates);
+        } else {
+          sync_ref_nonrepeating(DRAMAddr((void *) op.addr), sync_ref_threshold, a, immediates);
+        }
+        break;
+      case PatternOpType::LOOP_BACK:
+        a.jmp(for_begin);
+        break;
     }
-
-    // hammer
-    a.mov(asmjit::x86::rax, cur_addr);
-    a.mov(asmjit::x86::rcx, asmjit::x86::ptr(asmjit::x86::rax));
-    accessed_before[row] = true;
-    a.dec(asmjit::x86::rsi);
-    a.inc(asmjit::x86::edx);
-    cnt_total_activations++;
-
-    // flush
-    if (flushing==FLUSHING_STRATEGY::EARLIEST_POSSIBLE) {
-      a.mov(asmjit::x86::rax, cur_addr);
-      a.clflushopt(asmjit::x86::ptr(asmjit::x86::rax));
-    }
-  }
-
-  //we have not flushed any aggressors during the loop, so we need to do it now.
-  if (flushing == FLUSHING_STRATEGY::OMIT_FLUSHING) {
-    for(auto& agg : aggressor_pairs) {
-      a.mov(asmjit::x86::rax, agg);
-      a.clflushopt(asmjit::x86::ptr(asmjit::x86::rax));
-    }
-  }
-
-  // fences -> ensure that aggressors are not interleaved, i.e., we access aggressors always in same order
-  if (fencing != FENCING_STRATEGY::OMIT_FENCING) {
-    fence_fn(a);
   }
-
-  // ------- part 3: synchronize with the end  -----------------------------------------------------------------------
-
-  sync_ref_nonrepeating(sync_ref_initial_aggr, DRAMConfig::get().get_sync_ref_threshold(), a);
-
-  a.jmp(for_begin);
   a.bind(for_end);
 
   // Move ACT count to %r14.
@@ -236,13 +454,6 @@ void CodeJitter::jit_strict(
   // now move our counter for no. of activations in the end of interval sync. to the 1st output register %eax
   a.mov(asmjit::x86::eax, asmjit::x86::edx);
   a.ret();  // this is ESSENTIAL otherwise execution of jitted code creates a segfault
-
-  // add the generated code to the runtime.
-  asmjit::Error err = runtime.add(&fn, &code);
-  if (err) throw std::runtime_error("[-] Error occurred while jitting code. Aborting execution!");
-
-  // uncomment the following line to see the jitted ASM code
-  // printf("[DEBUG] asmjit logger content:\n%s\n", logger->corrupted_data());
 }
 
 void CodeJitter::sync_ref(const std::vector<volatile char *> &aggressor_pairs, asmjit::x86::Assembler &assembler) {
@@ -294,9 +505,31 @@ void CodeJitter::sync_ref(const std::vector<volatile char *> &aggressor_pairs, a
   assembler.bind(wend);
 }
 
+void CodeJitter::emit_address(asmjit::x86::Assembler &assembler, uint64_t addr, AddressImmediates *immediates) {
+  // movabs always encodes the full 8-byte immediate as the last bytes of the instruction, this way it can be patched
+  assembler.movabs(asmjit::x86::rax, addr);
+  if (immediates != nullptr) {
+    immediates->emplace_back(assembler.offset() - sizeof(uint64_t), addr);
+  }
+}
+
+std::vector<volatile char *> CodeJitter::sync_ref_addresses(DRAMAddr initial_aggressor) {
+  // Weird row increment to hopefully not trigger the prefetcher.
+  constexpr size_t AGGR_ROW_INCREMENT = 17;
+
+  std::vector<volatile char *> addresses;
+  auto current_aggr = initial_aggressor;
+  for (size_t i = 0; i < SYNC_REF_NUM_AGGRS; i++) {
+    addresses.push_back((volatile char *) current_aggr.to_virt());
+    current_aggr.add_inplace(0, AGGR_ROW_INCREMENT, 0);
+  }
+  return addresses;
+}
+
 // This function accesses a list of rows starting from initial_aggressors. It measures the access time between
 // aggressors until REF is detected. Then it flushes all aggressors using clflush and hands control back.
-void CodeJitter::sync_ref_nonrepeating(DRAMAddr inital_aggressor, size_t sync_ref_threshold, asmjit::x86::Assembler& assembler) {
+void CodeJitter::sync_ref_nonrepeating(DRAMAddr inital_aggressor, size_t sync_ref_threshold, asmjit::x86::Assembler& assembler,
+                                       AddressImmediates *immediates) {
   asmjit::Label out = assembler.newLabel();
 
   // PRE: %edx is an in-out argument containing the number of ACTs done for synchronization.
@@ -312,15 +545,10 @@ void CodeJitter::sync_ref_nonrepeating(DRAMAddr inital_aggressor, size_t sync_re
   // Serialize rdtscp from below.
   assembler.lfence();
 
-  // Weird row increment to hopefully not trigger the prefetcher.
-  constexpr size_t AGGR_ROW_INCREMENT = 17;
-
-  auto current_aggr = inital_aggressor;
+  auto sync_rows = sync_ref_addresses(inital_aggressor);
   for (size_t i = 0; i < SYNC_REF_NUM_AGGRS; i++) {
-    auto current = current_aggr.to_virt();
-    assembler.mov(asmjit::x86::rax, (uint64_t)current);
+    emit_address(assembler, (uint64_t) sync_rows[i], immediates);
     assembler.mov(asmjit::x86::rcx, asmjit::x86::ptr(asmjit::x86::rax));
-    current_aggr.add_inplace(0, AGGR_ROW_INCREMENT, 0);
 
     // Increment %r10, which counts the number of ACTs.
     assembler.inc(asmjit::x86::r10d);
@@ -348,18 +576,92 @@ void CodeJitter::sync_ref_nonrepeating(DRAMAddr inital_aggressor, size_t sync_re
   assembler.bind(out);
 
   // Flush all aggressors from cache.
-  current_aggr = inital_aggressor;
   for (size_t i = 0; i < SYNC_REF_NUM_AGGRS; i++) {
-    auto current = current_aggr.to_virt();
-    assembler.mov(asmjit::x86::rax, (uint64_t)current);
+    emit_address(assembler, (uint64_t) sync_rows[i], immediates);
     assembler.clflushopt(asmjit::x86::ptr(asmjit::x86::rax));
-    current_aggr.add_inplace(0, AGGR_ROW_INCREMENT, 0);
   }
 
   // Move ACT count from %r10d back to %edx.
   assembler.mov(asmjit::x86::edx, asmjit::x86::r10d);
 }
 
+// This function waits until the TSC reaches the next REF edge published by the RefPhaseTracker. If the published edge
+// already passed (e.g., because the tracker has not observed it yet), it waits for the next edge after now, assuming the
+// published period. No rows are accessed, hence no ACTs are spent on the synchronization.
+void CodeJitter::sync_ref_predicted(DRAMAddr fallback_aggressor, size_t sync_ref_threshold,
+                                    asmjit::x86::Assembler &assembler, AddressImmediates *immediates) {
+  asmjit::Label read = assembler.newLabel();
+  asmjit::Label retry = assembler.newLabel();
+  asmjit::Label wait = assembler.newLabel();
+  asmjit::Label spin = assembler.newLabel();
+  asmjit::Label fallback = assembler.newLabel();
+  asmjit::Label done = assembler.newLabel();
+
+  // PRE: %edx is an in-out argument containing the number of ACTs done for synchronization (unchanged here).
+
+  // Move ACT count from %edx to %r10d.
+  assembler.mov(asmjit::x86::r10d, asmjit::x86::edx);
+
+  // %r8 = next edge, %r9 = period, read under the sequence counter (see RefPrediction::publish); x86 does not reorder
+  // loads with other loads, hence no fences are required.
+  assembler.movabs(asmjit::x86::r11, (uint64_t) &RefPhaseTracker::get().get_prediction());
+  assembler.jmp(read);
+  assembler.bind(retry);
+  assembler.pause();
+  assembler.bind(read);
+  assembler.mov(asmjit::x86::rdx, asmjit::x86::ptr(asmjit::x86::r11, offsetof(RefPrediction, sequence)));
+  assembler.test(asmjit::x86::edx, 1);
+  assembler.jnz(retry);
+  assembler.mov(asmjit::x86::r8, asmjit::x86::ptr(asmjit::x86::r11, offsetof(RefPrediction, next_edge)));
+  assembler.mov(asmjit::x86::r9, asmjit::x86::ptr(asmjit::x86::r11, offsetof(RefPrediction, period)));
+  assembler.cmp(asmjit::x86::rdx, asmjit::x86::ptr(asmjit::x86::r11, offsetof(RefPrediction, sequence)));
+  assembler.jne(retry);
+
+  // without a period (the tracker is not locked yet), probe for REF instead
+  assembler.test(asmjit::x86::r9, asmjit::x86::r9);
+  assembler.jz(fallback);
+
+  // %rax = now
+  assembler.lfence();
+  assembler.rdtscp();
+  assembler.shl(asmjit::x86::rdx, 32);
+  assembler.or_(asmjit::x86::rax, asmjit::x86::rdx);
+
+  // if (now < next edge) wait for it
+  assembler.cmp(asmjit::x86::rax, asmjit::x86::r8);
+  assembler.jb(wait);
+
+  // else %r8 += ((now - next edge) / period + 1) * period
+  assembler.sub(asmjit::x86::rax, asmjit::x86::r8);
+  assembler.xor_(asmjit::x86::edx, asmjit::x86::edx);
+  assembler.div(asmjit::x86::rdx, asmjit::x86::rax, asmjit::x86::r9);
+  assembler.inc(asmjit::x86::rax);
+  assembler.imul(asmjit::x86::rax, asmjit::x86::r9);
+  assembler.add(asmjit::x86::r8, asmjit::x86::rax);
+  assembler.jmp(wait);
+
+  // spin until the TSC passed the edge
+  assembler.bind(spin);
+  assembler.pause();
+  assembler.bind(wait);
+  assembler.rdtscp();
+  assembler.shl(asmjit::x86::rdx, 32);
+  assembler.or_(asmjit::x86::rax, asmjit::x86::rdx);
+  assembler.cmp(asmjit::x86::rax, asmjit::x86::r8);
+  assembler.jb(spin);
+  assembler.lfence();
+
+  // Move ACT count from %r10d back to %edx.
+  assembler.mov(asmjit::x86::edx, asmjit::x86::r10d);
+  assembler.jmp(done);
+
+  assembler.bind(fallback);
+  assembler.mov(asmjit::x86::edx, asmjit::x86::r10d);
+  sync_ref_nonrepeating(fallback_aggressor, sync_ref_threshold, assembler, immediates);
+
+  assembler.bind(done);
+}
+
 void CodeJitter::jit_ref_sync(
   FLUSHING_STRATEGY flushing,
   FENCING_STRATEGY fencing,
@@ -378,7 +680,7 @@ void CodeJitter::jit_ref_sync(
 
   // Initialize assembler.
   asmjit::CodeHolder code;
-  code.init(runtime.environment());
+  code.init(get_runtime().environment());
   asmjit::x86::Assembler assembler(&code);
 
   // PRE: %rdi (first register) contains a pointer to a struct RefSyncData, used to return the results.
@@ -462,7 +764,7 @@ void CodeJitter::jit_ref_sync(
   assembler.ret();
 
   // Add the generated code to the runtime.
-  asmjit::Error err = runtime.add(&fn_ref_sync, &code);
+  asmjit::Error err = runtime->add(&fn_ref_sync, &code);
   if (err) throw std::runtime_error("[-] Error occurred while jitting code. Aborting execution!");
 }
 #ifdef ENABLE_JSON
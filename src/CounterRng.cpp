@@ -0,0 +1,135 @@
+#include "CounterRng.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+static uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+CounterRng::CounterRng(uint64_t seed) {
+  set_seed(seed);
+}
+
+void CounterRng::set_seed(uint64_t seed) {
+  uint64_t key = splitmix64(seed);
+  key_lo = (uint32_t)key;
+  key_hi = (uint32_t)(key >> 32);
+}
+
+const char *CounterRng::kernel_name() {
+#if defined(__AVX512F__)
+  return "avx512";
+#elif defined(__AVX2__)
+  return "avx2";
+#else
+  return "scalar";
+#endif
+}
+
+#if defined(__AVX512F__)
+static inline __m512i mix_512(__m512i x) {
+  x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+  x = _mm512_mullo_epi32(x, _mm512_set1_epi32((int)0x7feb352dU));
+  x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 15));
+  x = _mm512_mullo_epi32(x, _mm512_set1_epi32((int)0x846ca68bU));
+  x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+  return x;
+}
+#elif defined(__AVX2__)
+static inline __m256i mix_256(__m256i x) {
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+  x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x7feb352dU));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+  x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x846ca68bU));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+  return x;
+}
+#endif
+
+void CounterRng::fill(uint32_t *dst, uint64_t offset, size_t nwords) const {
+  uint64_t idx = offset / sizeof(uint32_t);
+  while (nwords > 0) {
+    // split the range into segments in which the upper 32 bits of the word index (and thus the key) stay constant
+    uint32_t lo = (uint32_t)idx;
+    uint64_t segment_left = (1ULL << 32) - lo;
+    size_t n = nwords < segment_left ? nwords : (size_t)segment_left;
+    uint32_t key = segment_key((uint32_t)(idx >> 32));
+
+    size_t i = 0;
+#if defined(__AVX512F__)
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i vkey = _mm512_set1_epi32((int)key);
+    const __m512i vkey_hi = _mm512_set1_epi32((int)key_hi);
+    for (; i + 16 <= n; i += 16) {
+      __m512i x = _mm512_add_epi32(_mm512_set1_epi32((int)(lo + (uint32_t)i)), lanes);
+      x = mix_512(_mm512_add_epi32(x, vkey));
+      x = mix_512(_mm512_xor_si512(x, vkey_hi));
+      _mm512_storeu_si512((void *)(dst + i), x);
+    }
+#elif defined(__AVX2__)
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i vkey = _mm256_set1_epi32((int)key);
+    const __m256i vkey_hi = _mm256_set1_epi32((int)key_hi);
+    for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_add_epi32(_mm256_set1_epi32((int)(lo + (uint32_t)i)), lanes);
+      x = mix_256(_mm256_add_epi32(x, vkey));
+      x = mix_256(_mm256_xor_si256(x, vkey_hi));
+      _mm256_storeu_si256((__m256i *)(dst + i), x);
+    }
+#endif
+    for (; i < n; i++) {
+      dst[i] = mix(mix(lo + (uint32_t)i + key) ^ key_hi);
+    }
+
+    dst += n;
+    idx += n;
+    nwords -= n;
+  }
+}
+
+bool CounterRng::matches(const volatile void *mem, uint64_t offset, size_t nwords) const {
+  const auto *src = (const uint32_t *) mem;
+  uint64_t idx = offset / sizeof(uint32_t);
+  while (nwords > 0) {
+    uint32_t lo = (uint32_t)idx;
+    uint64_t segment_left = (1ULL << 32) - lo;
+    size_t n = nwords < segment_left ? nwords : (size_t)segment_left;
+    uint32_t key = segment_key((uint32_t)(idx >> 32));
+
+    size_t i = 0;
+#if defined(__AVX512F__)
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i vkey = _mm512_set1_epi32((int)key);
+    const __m512i vkey_hi = _mm512_set1_epi32((int)key_hi);
+    for (; i + 16 <= n; i += 16) {
+      __m512i x = _mm512_add_epi32(_mm512_set1_epi32((int)(lo + (uint32_t)i)), lanes);
+      x = mix_512(_mm512_add_epi32(x, vkey));
+      x = mix_512(_mm512_xor_si512(x, vkey_hi));
+      if (_mm512_cmpneq_epi32_mask(x, _mm512_loadu_si512((const void *)(src + i))) != 0) return false;
+    }
+#elif defined(__AVX2__)
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i vkey = _mm256_set1_epi32((int)key);
+    const __m256i vkey_hi = _mm256_set1_epi32((int)key_hi);
+    for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_add_epi32(_mm256_set1_epi32((int)(lo + (uint32_t)i)), lanes);
+      x = mix_256(_mm256_add_epi32(x, vkey));
+      x = mix_256(_mm256_xor_si256(x, vkey_hi));
+      __m256i diff = _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i *)(src + i)));
+      if (!_mm256_testz_si256(diff, diff)) return false;
+    }
+#endif
+    for (; i < n; i++) {
+      if (src[i] != mix(mix(lo + (uint32_t)i + key) ^ key_hi)) return false;
+    }
+
+    src += n;
+    idx += n;
+    nwords -= n;
+  }
+  return true;
+}
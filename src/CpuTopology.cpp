@@ -0,0 +1,240 @@
+#include "CpuTopology.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#define SYSFS_CPU "/sys/devices/system/cpu/"
+
+// parses a CPU list like "0-3,8,10-11"
+static std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+static bool read_line(const std::string &path, std::string &line) {
+  std::ifstream f(path);
+  return f.is_open() && std::getline(f, line) && !line.empty();
+}
+
+static int read_int(const std::string &path, int fallback) {
+  std::string line;
+  return read_line(path, line) ? std::stoi(line) : fallback;
+}
+
+CpuTopology &CpuTopology::get() {
+  static CpuTopology instance;
+  return instance;
+}
+
+CpuTopology::CpuTopology() {
+  std::string online;
+  std::vector<int> online_cpus;
+  if (read_line(SYSFS_CPU "online", online)) {
+    online_cpus = parse_cpu_list(online);
+  }
+  if (online_cpus.empty()) {
+    // no sysfs: treat each CPU as a separate core
+    Logger::log_info("Could not read the CPU topology, assuming one core per CPU.");
+    for (int cpu = 0; cpu < (int) std::max(1u, std::thread::hardware_concurrency()); cpu++) {
+      cpus.push_back({cpu, 0, cpu, cpu, 0, 0});
+    }
+    return;
+  }
+
+  for (auto cpu : online_cpus) {
+    auto dir = std::string(SYSFS_CPU "cpu") + std::to_string(cpu) + "/";
+    CpuInfo info { cpu, read_int(dir + "topology/physical_package_id", 0), read_int(dir + "topology/core_id", cpu), cpu,
+                   0, 0 };
+
+    std::string siblings;
+    if (read_line(dir + "topology/thread_siblings_list", siblings)) {
+      auto threads = parse_cpu_list(siblings);
+      info.smt_index = (int) (std::find(threads.begin(), threads.end(), cpu) - threads.begin());
+    }
+
+    // the last level cache is the cache index with the highest level
+    int llc_level = 0;
+    for (int idx = 0; std::filesystem::exists(dir + "cache/index" + std::to_string(idx)); idx++) {
+      auto cache = dir + "cache/index" + std::to_string(idx) + "/";
+      int level = read_int(cache + "level", 0);
+      std::string shared;
+      if (level >= llc_level && read_line(cache + "shared_cpu_list", shared)) {
+        auto sharing = parse_cpu_list(shared);
+        if (!sharing.empty()) {
+          llc_level = level;
+          info.llc = *std::min_element(sharing.begin(), sharing.end());
+        }
+      }
+    }
+
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+      auto name = entry.path().filename().string();
+      if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit(name[4])) {
+        info.node = std::stoi(name.substr(4));
+      }
+    }
+
+    cpus.push_back(info);
+  }
+}
+
+std::vector<std::vector<int>> CpuTopology::physical_cores() const {
+  std::map<std::tuple<int, int, int, int>, std::vector<std::pair<int, int>>> cores;
+  for (const auto &info : cpus) {
+    cores[{info.package, info.llc, info.core, info.node}].emplace_back(info.smt_index, info.cpu);
+  }
+  std::vector<std::vector<int>> result;
+  result.reserve(cores.size());
+  for (auto &[id, threads] : cores) {
+    std::sort(threads.begin(), threads.end());
+    auto &core = result.emplace_back();
+    for (auto &[smt_index, cpu] : threads) {
+      core.push_back(cpu);
+    }
+  }
+  return result;
+}
+
+size_t CpuTopology::num_physical_cores() const {
+  return physical_cores().size();
+}
+
+size_t CpuTopology::num_llcs() const {
+  std::set<int> llcs;
+  for (const auto &info : cpus) llcs.insert(info.llc);
+  return llcs.size();
+}
+
+size_t CpuTopology::num_nodes() const {
+  return get_nodes().size();
+}
+
+std::vector<int> CpuTopology::get_nodes() const {
+  std::set<int> nodes;
+  for (const auto &info : cpus) nodes.insert(info.node);
+  return { nodes.begin(), nodes.end() };
+}
+
+static int llc_of(const std::vector<CpuInfo> &cpus, int cpu) {
+  for (const auto &info : cpus) {
+    if (info.cpu == cpu) return info.llc;
+  }
+  return -1;
+}
+
+std::vector<int> CpuTopology::place(PLACEMENT_POLICY policy, size_t num_threads, size_t offset) const {
+  std::vector<int> placement;
+  placement.reserve(num_threads);
+  if (policy == PLACEMENT_POLICY::LEGACY) {
+    for (size_t i = 0; i < num_threads; i++) {
+      placement.push_back((int) ((offset + i) % 16));
+    }
+    return placement;
+  }
+
+  auto cores = physical_cores();
+  std::rotate(cores.begin(), cores.begin() + (long) (offset % cores.size()), cores.end());
+  size_t max_smt = 0;
+  for (const auto &core : cores) max_smt = std::max(max_smt, core.size());
+
+  // the CPUs in the order in which they are assigned to the threads
+  std::vector<int> order;
+  switch (policy) {
+    case PLACEMENT_POLICY::SMT_PAIRS:
+      for (const auto &core : cores) {
+        order.insert(order.end(), core.begin(), core.end());
+      }
+      break;
+    case PLACEMENT_POLICY::SAME_CCX: {
+      auto llc = llc_of(cpus, cores.front().front());
+      std::erase_if(cores, [&](const std::vector<int> &core) { return llc_of(cpus, core.front()) != llc; });
+    }
+      [[fallthrough]];
+    case PLACEMENT_POLICY::PHYSICAL_CORES:
+      // the first hardware thread of every core, then the second one, ...
+      for (size_t smt = 0; smt < max_smt; smt++) {
+        for (const auto &core : cores) {
+          if (smt < core.size()) order.push_back(core[smt]);
+        }
+      }
+      break;
+    case PLACEMENT_POLICY::SPREAD: {
+      // round-robin over the LLCs, starting with the one of the first core
+      std::vector<std::vector<const std::vector<int> *>> llcs;
+      std::map<int, size_t> llc_idx;
+      for (const auto &core : cores) {
+        auto [it, inserted] = llc_idx.emplace(llc_of(cpus, core.front()), llcs.size());
+        if (inserted) llcs.emplace_back();
+        llcs[it->second].push_back(&core);
+      }
+      size_t max_cores = 0;
+      for (const auto &llc : llcs) max_cores = std::max(max_cores, llc.size());
+      for (size_t smt = 0; smt < max_smt; smt++) {
+        for (size_t c = 0; c < max_cores; c++) {
+          for (const auto &llc : llcs) {
+            if (c < llc.size() && smt < llc[c]->size()) order.push_back((*llc[c])[smt]);
+          }
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  if (num_threads > order.size()) {
+    Logger::log_info(format_string("Placement %s only has %lu CPUs for %lu threads, oversubscribing.",
+        ::to_string(policy).c_str(), order.size(), num_threads));
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    placement.push_back(order[i % order.size()]);
+  }
+  return placement;
+}
+
+int CpuTopology::helper_cpu(const std::vector<int> &used) const {
+  auto cores = physical_cores();
+  int node = 0;
+  for (const auto &info : cpus) {
+    if (!used.empty() && info.cpu == used.front()) node = info.node;
+  }
+
+  auto is_free = [&](const std::vector<int> &core) {
+    return std::none_of(core.begin(), core.end(), [&](int cpu) {
+      return std::find(used.begin(), used.end(), cpu) != used.end();
+    });
+  };
+  int fallback = -1;
+  for (const auto &core : cores) {
+    if (!is_free(core)) continue;
+    for (const auto &info : cpus) {
+      if (info.cpu == core.front() && info.node == node) return core.front();
+    }
+    if (fallback < 0) fallback = core.front();
+  }
+  return fallback >= 0 ? fallback : cpus.back().cpu;
+}
+
+std::string CpuTopology::to_string() const {
+  return format_string("%lu CPUs, %lu physical cores, %lu LLCs, %lu NUMA nodes", cpus.size(), num_physical_cores(),
+      num_llcs(), num_nodes());
+}
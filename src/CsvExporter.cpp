@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <vector>
 
 CsvExporter::CsvExporter(std::string filepath) : path(filepath) {
   logfile = fopen(path.c_str(), "w");
@@ -19,6 +20,24 @@ CsvExporter::~CsvExporter() {
 }
 
 void CsvExporter::export_flip(BitFlip &flip, int run, int location, int pattern, int n_patterns, int n_aggs, int n_accesses, std::chrono::duration<float_t> duration) {
+  write_flip(flip, Memory::get_physical_address((uint64_t)flip.address.to_virt()), run, location, pattern, n_patterns, n_aggs, n_accesses, duration);
+}
+
+void CsvExporter::export_flips(std::vector<BitFlip> &flips, int run, int location, int pattern, int n_patterns, int n_aggs, int n_accesses, std::chrono::duration<float_t> duration) {
+  // translate all addresses at once instead of one lookup per flip
+  std::vector<uint64_t> vaddrs;
+  vaddrs.reserve(flips.size());
+  for (auto &flip : flips) {
+    vaddrs.push_back((uint64_t)flip.address.to_virt());
+  }
+  std::vector<uint64_t> paddrs;
+  Memory::get_physical_addresses(vaddrs, paddrs);
+  for (size_t i = 0; i < flips.size(); i++) {
+    write_flip(flips[i], paddrs[i], run, location, pattern, n_patterns, n_aggs, n_accesses, duration);
+  }
+}
+
+void CsvExporter::write_flip(BitFlip &flip, uint64_t phys_addr, int run, int location, int pattern, int n_patterns, int n_aggs, int n_accesses, std::chrono::duration<float_t> duration) {
   fprintf(logfile, "%d;%d;%d;%d;%d;%d;%lu;%lu;%lu;%lu;%lx;%b;%lu;%lu\n",
           run,
           location,
@@ -30,7 +49,7 @@ void CsvExporter::export_flip(BitFlip &flip, int run, int location, int pattern,
           flip.address.actual_bank(),
           flip.address.actual_row(),
           flip.address.actual_column(),
-          Memory::get_physical_address((uint64_t)flip.address.to_virt()),
+          phys_addr,
           flip.bitmask,
           flip.count_o2z_corruptions(),
           flip.count_z2o_corruptions());
@@ -4,11 +4,8 @@
 #include <map>
 #include <cassert>
 static std::map<int, size_t> base_msb_for_mapping;
-static struct {
-  int from_mapping_id { -1 };
-  int to_mapping_id { -1 };
-  std::vector<size_t> translation;
-} translation_data;
+// (from_mapping_id, to_mapping_id) -> translation[bank in from mapping] = same bank in to mapping
+static std::map<std::pair<int, int>, std::vector<size_t>> translation_data;
 
 void DRAMAddr::initialize_mapping(int mapping_id, volatile char *start_address) {
   // Set the bits above the ones covered by the matrices (i.e., the bits that stay constant for all addresses).
@@ -18,26 +15,34 @@ void DRAMAddr::initialize_mapping(int mapping_id, volatile char *start_address)
   Logger::log_info(format_string("DRAMAddr: Initialized MSBs for mapping_id = %d: %p", mapping_id, (void*)base_msb));
 }
 
+size_t DRAMAddr::num_mappings() {
+  return base_msb_for_mapping.size();
+}
+
 void DRAMAddr::initialize_bank_translation(int from_mapping_id, int to_mapping_id, std::vector<size_t> translation) {
-  translation_data.from_mapping_id = from_mapping_id;
-  translation_data.to_mapping_id = to_mapping_id;
-  translation_data.translation = std::move(translation);
+  assert(translation.size() == DRAMConfig::get().banks());
+  // also store the inverse translation
+  std::vector<size_t> inverse(translation.size());
+  for (size_t bank = 0; bank < translation.size(); bank++) {
+    inverse[translation[bank]] = bank;
+  }
+  translation_data[{to_mapping_id, from_mapping_id}] = std::move(inverse);
+  translation_data[{from_mapping_id, to_mapping_id}] = std::move(translation);
 }
 
 size_t DRAMAddr::translate_bank(int from_mapping_id, int to_mapping_id, size_t bank) {
-  if (translation_data.from_mapping_id != from_mapping_id || translation_data.to_mapping_id != to_mapping_id) {
+  if (from_mapping_id == to_mapping_id) {
+    return bank % DRAMConfig::get().banks();
+  }
+  auto it = translation_data.find({from_mapping_id, to_mapping_id});
+  if (it == translation_data.end()) {
     Logger::log_error(format_string(
       "Error: Cannot translate bank from mapping %d to mapping %d as no translation data is available.",
       from_mapping_id,
       to_mapping_id));
-    Logger::log_info(format_string(
-      "Translation data is available for translation from mapping %d to mapping %d.",
-      translation_data.from_mapping_id,
-      translation_data.to_mapping_id));
     exit(EXIT_FAILURE);
   }
-  assert(translation_data.translation.size() == DRAMConfig::get().banks());
-  return translation_data.translation[bank % DRAMConfig::get().banks()];
+  return it->second[bank % DRAMConfig::get().banks()];
 }
 
 DRAMAddr::DRAMAddr(void *addr) {
@@ -112,7 +117,7 @@ std::string DRAMAddr::to_string_compact() const {
 }
 
 DRAMAddr DRAMAddr::add(size_t bank_increment, size_t row_increment, size_t column_increment) const {
-  return {bank + bank_increment, row + row_increment, col + column_increment};
+  return {bank + bank_increment, row + row_increment, col + column_increment, mapping_id};
 }
 
 void DRAMAddr::add_inplace(size_t bank_increment, size_t row_increment, size_t column_increment) {
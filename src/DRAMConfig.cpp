@@ -30,6 +30,18 @@ const char* to_string(Microarchitecture uarch) {
   exit(1);
 }
 
+const char* to_string(TranslationMethod method) {
+  switch (method) {
+    case TranslationMethod::PARITY:
+      return "PARITY";
+    case TranslationMethod::LOOKUP_TABLE:
+      return "LOOKUP_TABLE";
+    case TranslationMethod::PEXT:
+      return "PEXT";
+  }
+  return "UNKNOWN";
+}
+
 static std::string get_cpu_model_string() {
   std::string cpu_model;
   std::array<char, 128> buffer {};
@@ -1885,9 +1897,13 @@ void DRAMConfig::select_config(Microarchitecture uarch, int ranks, int bank_grou
   selected_config->uarch = uarch;
 
   Logger::log_info("Selected DRAM config includes the following parameters:");
-  Logger::log_data(format_string("    sync_ref_threshold = %lu", selected_config->sync_ref_threshold));
+  Logger::log_data(format_string("    sync_ref_threshold = %lu", selected_config->sync_ref_threshold.load()));
 
   selected_config->check_validity();
+
+  selected_config->select_fastest_translation();
+  Logger::log_data(format_string("    dram_translation   = %s", to_string(selected_config->dram_translation.method)));
+  Logger::log_data(format_string("    addr_translation   = %s", to_string(selected_config->addr_translation.method)));
 }
 
 void DRAMConfig::select_config(std::string const& uarch_str, int ranks, int bank_groups, int banks, bool samsung_row_mapping) {
@@ -2005,3 +2021,71 @@ size_t DRAMConfig::apply_matrix(const std::vector<size_t>& matrix, size_t addr)
   }
   return result;
 }
+
+bool DRAMConfig::prepare_translation(Translation& translation, const std::vector<size_t>& matrix,
+                                     TranslationMethod method) const {
+  switch (method) {
+    case TranslationMethod::PARITY:
+      translation.method = method;
+      translation.tables.clear();
+      return true;
+    case TranslationMethod::LOOKUP_TABLE: {
+      // One table per byte covered by the matrix; the rows do not select any bits above matrix_size.
+      std::vector<std::array<size_t, 256>> tables((matrix_size + 7) / 8);
+      for (size_t k = 0; k < tables.size(); k++) {
+        for (size_t b = 0; b < 256; b++) {
+          tables[k][b] = apply_matrix(matrix, b << (8 * k));
+        }
+      }
+      translation.method = method;
+      translation.tables = std::move(tables);
+      return true;
+    }
+    case TranslationMethod::PEXT: {
+#ifdef __BMI2__
+      // PEXT packs the selected bits in ascending order, while the first row of the matrix yields the most significant
+      // result bit. Hence, every row must select a single bit, and the rows must select descending bits.
+      size_t mask = 0;
+      for (size_t i = 0; i < matrix.size(); i++) {
+        if (__builtin_popcountll(matrix[i]) != 1 || (i > 0 && matrix[i] >= matrix[i - 1])) {
+          return false;
+        }
+        mask |= matrix[i];
+      }
+      translation.method = method;
+      translation.pext_mask = mask;
+      translation.tables.clear();
+      return true;
+#else
+      return false;
+#endif
+    }
+  }
+  return false;
+}
+
+void DRAMConfig::prepare_fastest_translation(Translation& translation, const std::vector<size_t>& matrix) const {
+  // PEXT is microcoded and takes tens of cycles before Zen 3, which is slower than the lookup tables.
+  bool fast_pext = uarch != Microarchitecture::AMD_ZEN_1_PLUS && uarch != Microarchitecture::AMD_ZEN_2;
+  if (fast_pext && prepare_translation(translation, matrix, TranslationMethod::PEXT)) {
+    return;
+  }
+  (void)prepare_translation(translation, matrix, TranslationMethod::LOOKUP_TABLE);
+}
+
+void DRAMConfig::select_fastest_translation() {
+  prepare_fastest_translation(dram_translation, dram_matrix);
+  prepare_fastest_translation(addr_translation, addr_matrix);
+}
+
+bool DRAMConfig::set_translation_method(TranslationMethod method) {
+  bool dram_ok = prepare_translation(dram_translation, dram_matrix, method);
+  bool addr_ok = prepare_translation(addr_translation, addr_matrix, method);
+  if (!dram_ok) {
+    prepare_fastest_translation(dram_translation, dram_matrix);
+  }
+  if (!addr_ok) {
+    prepare_fastest_translation(addr_translation, addr_matrix);
+  }
+  return dram_ok && addr_ok;
+}
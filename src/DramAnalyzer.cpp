@@ -3,6 +3,9 @@
 #include "CodeJitter.hpp"
 #include "DRAMAddr.hpp"
 #include "DRAMConfig.hpp"
+#include "RefreshTimer.hpp"
+#include "TimingStats.hpp"
+#include <algorithm>
 #include <cmath>
 #include <x86intrin.h>
 
@@ -10,123 +13,22 @@
 #include <random>
 #include <unordered_set>
 
-const size_t N_MEASUREMENTS = 300000;
-
-void take_measurements(measurement* arr, size_t n, volatile char* row) {
-  uint32_t tsc_aux;
-  for(int i = 0; i < n; i++) {
-    _mm_mfence(); 
-    uint64_t start = __rdtscp(&tsc_aux);
-    _mm_lfence();
-
-    *row;
-
-    _mm_lfence();
-    uint64_t end = __rdtscp(&tsc_aux);
-
-    arr[i].duration = end - start;
-    arr[i].ts = end;
-    
-    _mm_clflush((void*)row);
-  }
-}
-
-int compare_int( const void* a, const void* b )
-{
-  if( *(uint64_t*)a == *(uint64_t*)b ) return 0;
-  return *(uint64_t*)a < *(uint64_t*)b ? -1 : 1;
-}
-
-uint64_t median(uint64_t arr[], size_t n) {
-  uint64_t* cpy = (uint64_t*)malloc(n * sizeof(uint64_t));
-  memcpy(cpy, arr, n * sizeof(uint64_t));
-  qsort(cpy, n, sizeof(uint64_t), compare_int);
-  uint64_t med = *(cpy + n / 2);
-  free(cpy);
-  return med;
-}
-
-uint64_t find_threshold_new(measurement times[], size_t n) {
-  uint64_t sum = 0;
-
-  for(int i = 0; i < N_MEASUREMENTS; i++) {
-    sum += times[i].duration;
-  }
-
-  double avg = (double)sum / N_MEASUREMENTS;
-  printf("the average measurement duration was %f ns based on %lu measurements and a sum of %lu, determining refresh interval...\n", avg, N_MEASUREMENTS, sum);
-
-  uint64_t peaks[N_MEASUREMENTS];
-  size_t npeaks = 0;
-  for(size_t i = 0; i < N_MEASUREMENTS; i++) {
-    if(times[i].duration > avg * 1.02) {
-      peaks[npeaks++] = times[i].duration;
-    }
-  }
-  printf("found %lu peaks.\n", npeaks);
-
-  uint64_t med = median(peaks, npeaks);
-  printf("median peak duration seems to be %lu ns\n", med);
-  return avg + ((med - avg) / 2);
-}
-
-double_t avg_trefi(measurement times[], size_t n) {
-  uint64_t threshold = find_threshold_new(times, n);
-  uint64_t lpeak = 0;
-  uint64_t peak_sum = 0;
-  uint64_t npeaks = 0;
-  for(int i = 0; i < n; i++) {
-    if(times[i].duration > threshold) {
-      npeaks++;
-      if(lpeak != 0) {
-        peak_sum += times[i].ts - lpeak;
-      }
-      lpeak = times[i].ts;
-    }
-  }
-
-  return peak_sum / (double_t)npeaks;
-}
-
-measurement* measure(volatile char* base)
-{
-  measurement times[N_MEASUREMENTS];
-
-  //used as a preparation period for the OS to finish scheduling the program
-  take_measurements(times, N_MEASUREMENTS / 10, base);
-  sched_yield();
-  take_measurements(times, N_MEASUREMENTS, base);
-
-  return times;
-}
-
 void DramAnalyzer::find_threshold() {
   assert(threshold == (size_t)-1 && "find_threshold() has not been called yet.");
   Logger::log_info("Generating histogram data to find bank conflict threshold.");
   constexpr size_t HISTOGRAM_MAX_VALUE = 4096;
   constexpr size_t HISTOGRAM_ENTRIES = 16384;
 
-  std::vector<size_t> histogram(HISTOGRAM_MAX_VALUE, 0);
-  size_t num_entries = 0;
-
-  while (num_entries < HISTOGRAM_ENTRIES) {
+  Histogram histogram(HISTOGRAM_MAX_VALUE);
+  while (histogram.size() < HISTOGRAM_ENTRIES) {
     auto a1 = get_random_address();
     auto a2 = get_random_address();
-    auto time = (size_t)measure_time(a1, a2);
-    if (time < histogram.size()) {
-      histogram[time]++;
-      num_entries++;
-    }
+    histogram.add(measure_time(a1, a2));
   }
 
   // Find threshold such that HISTOGRAM_ENTRIES / NUM_BANKS times are above it.
-  threshold = HISTOGRAM_MAX_VALUE - 1;
-  size_t num_entries_above_threshold = 0;
-  while (num_entries_above_threshold < HISTOGRAM_ENTRIES / DRAMConfig::get().banks()) {
-    num_entries_above_threshold += histogram[threshold];
-    threshold--;
-    assert(threshold > 0);
-  }
+  threshold = histogram.top(HISTOGRAM_ENTRIES / DRAMConfig::get().banks()) - 1;
+  assert(threshold > 0);
 
   Logger::log_info(format_string("Found bank conflict threshold to be %zu.", threshold));
 }
@@ -186,31 +88,26 @@ DramAnalyzer::DramAnalyzer(volatile char *target) :
 }
 
 size_t DramAnalyzer::count_acts_per_trefi() {
-  size_t skip_first_N = 50;
   // pick two random same-bank addresses
-  volatile char *a = banks.at(0).at(0);
-  volatile char *b = banks.at(0).at(1);
+  auto activations = count_acts_per_trefi(banks.at(0).at(0), banks.at(0).at(1));
+  Logger::log_info("Determined the number of possible ACTs per refresh interval.");
+  Logger::log_data(format_string("num_acts_per_tREFI: %lu", activations));
+
+  return activations;
+}
 
-  std::vector<uint64_t> acts;
-  uint64_t running_sum = 0;
+size_t DramAnalyzer::count_acts_per_trefi(volatile char *a, volatile char *b) {
+  size_t skip_first_N = 50;
+
+  // bounds the memory and the duration if the measurements do not settle
+  constexpr size_t MAX_SAMPLES = 100000;
+  SampleBuffer acts(MAX_SAMPLES);
   uint64_t before;
   uint64_t after;
   uint64_t count = 0;
   uint64_t count_old = 0;
 
-  // computes the standard deviation
-  auto compute_std = [](std::vector<uint64_t> &values, uint64_t running_sum, size_t num_numbers) {
-    double mean = static_cast<double>(running_sum)/static_cast<double>(num_numbers);
-    double var = 0;
-    for (const auto &num : values) {
-      if (static_cast<double>(num) < mean) continue;
-      var += std::pow(static_cast<double>(num) - mean, 2);
-    }
-    auto val = std::sqrt(var/static_cast<double>(num_numbers));
-    return val;
-  };
-
-  for (size_t i = 0;; i++) {
+  for (size_t i = 0; !acts.full(); i++) {
     // flush a and b from caches
     clflushopt(a);
     clflushopt(b);
@@ -231,46 +128,24 @@ size_t DramAnalyzer::count_acts_per_trefi() {
     if ((after - before) > 1000) {
       if (i > skip_first_N && count_old!=0) {
         // multiply by 2 to account for both accesses we do (a, b)
-        uint64_t value = (count - count_old)*2;
-        acts.push_back(value);
-        running_sum += value;
+        acts.push((count - count_old)*2);
         // check after each 200 data points if our standard deviation reached 1 -> then stop collecting measurements
-        if ((acts.size()%200)==0 && compute_std(acts, running_sum, acts.size())<3.0) break;
+        if ((acts.size()%200)==0
+            && TimingStats::upper_semideviation(acts.data(), acts.size(), TimingStats::mean(acts.data(), acts.size()))<3.0) break;
       }
       count_old = count;
     }
   }
 
-  auto activations = (running_sum/acts.size());
-  Logger::log_info("Determined the number of possible ACTs per refresh interval.");
-  Logger::log_data(format_string("num_acts_per_tREFI: %lu", activations));
-
-  return activations;
+  return TimingStats::sum(acts.data(), acts.size())/acts.size();
 }
 
 size_t DramAnalyzer::find_sync_ref_threshold() {
-  Logger::log_info("Finding sync REF threshold using using jitted code.");
-  CodeJitter jitter;
-
-  // Idea: Start with a threshold that is definitely too high, wait until there are no overruns (i.e., # ACTs is the
-  // maximum, meaning no REF is detected) in any of the three sync attempts.
-
-  // Prepare aggressors.
-  constexpr size_t NUM_AGGRS = 32;
-  std::vector<volatile char*> aggressors;
-  for (size_t i = 0; i < NUM_AGGRS; i++) {
-    aggressors.push_back((volatile char*)DRAMAddr(0, 2 * i, 0).to_virt());
-  }
-
-  // Prepare REF sync address.
+  Logger::log_info("Finding sync REF threshold.");
+  // NOTE: This needs to be in the same rank, but a different bank w.r.t. the aggressors (bank 0).
   DRAMAddr initial_sync_addr(1, 0, 0);
-  measurement times[N_MEASUREMENTS];
-  take_measurements(times, N_MEASUREMENTS / 10, (volatile char *)initial_sync_addr.to_virt());
-  sched_yield();
-  take_measurements(times, N_MEASUREMENTS, (volatile char *)initial_sync_addr.to_virt());
-  // NOTE: This needs to be in the same rank, but a different bank w.r.t. the aggressors.
-  size_t t = find_threshold_new(times, N_MEASUREMENTS);
-  return t;
+  RefreshTimer timer((volatile char *)initial_sync_addr.to_virt());
+  return timer.get_refresh_threshold();
 }
 
 void DramAnalyzer::check_sync_ref_threshold(size_t sync_ref_threshold) {
@@ -94,3 +94,42 @@ std::string to_string(FENCE_TYPE type) {
       assert(false && "Unreachable.");
   }
 }
+
+std::string to_string(PLACEMENT_POLICY policy) {
+  switch (policy) {
+    case PLACEMENT_POLICY::LEGACY:
+      return "LEGACY";
+    case PLACEMENT_POLICY::PHYSICAL_CORES:
+      return "PHYSICAL_CORES";
+    case PLACEMENT_POLICY::SMT_PAIRS:
+      return "SMT_PAIRS";
+    case PLACEMENT_POLICY::SAME_CCX:
+      return "SAME_CCX";
+    case PLACEMENT_POLICY::SPREAD:
+      return "SPREAD";
+    default:
+      assert(false && "Unreachable.");
+  }
+}
+
+std::string to_string(JIT_EMITTER emitter) {
+  switch (emitter) {
+    case JIT_EMITTER::UNROLLED:
+      return "UNROLLED";
+    case JIT_EMITTER::COMPACT:
+      return "COMPACT";
+    default:
+      assert(false && "Unreachable.");
+  }
+}
+
+std::string to_string(SYNC_MODE mode) {
+  switch (mode) {
+    case SYNC_MODE::PROBE:
+      return "PROBE";
+    case SYNC_MODE::PREDICTED:
+      return "PREDICTED";
+    default:
+      assert(false && "Unreachable.");
+  }
+}
@@ -0,0 +1,85 @@
+#include "FlipStore.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#define PACKED_COL_BITS 16
+#define PACKED_ROW_BITS 24
+#define PACKED_BANK_BITS 16
+#define PACKED_MAPPING_BITS 8
+
+FlipStore &FlipStore::get() {
+  static FlipStore instance;
+  return instance;
+}
+
+uint64_t FlipStore::pack(const DRAMAddr &addr) {
+  auto bank = addr.actual_bank();
+  auto row = addr.actual_row();
+  auto col = addr.actual_column();
+  assert(bank < (1ULL << PACKED_BANK_BITS) && row < (1ULL << PACKED_ROW_BITS) && col < (1ULL << PACKED_COL_BITS));
+  assert(addr.mapping_id >= 0 && addr.mapping_id < (1 << PACKED_MAPPING_BITS));
+  return ((uint64_t) addr.mapping_id << (PACKED_BANK_BITS + PACKED_ROW_BITS + PACKED_COL_BITS))
+      | ((uint64_t) bank << (PACKED_ROW_BITS + PACKED_COL_BITS))
+      | ((uint64_t) row << PACKED_COL_BITS)
+      | (uint64_t) col;
+}
+
+DRAMAddr FlipStore::unpack(uint64_t packed) {
+  auto col = packed & ((1ULL << PACKED_COL_BITS) - 1);
+  auto row = (packed >> PACKED_COL_BITS) & ((1ULL << PACKED_ROW_BITS) - 1);
+  auto bank = (packed >> (PACKED_ROW_BITS + PACKED_COL_BITS)) & ((1ULL << PACKED_BANK_BITS) - 1);
+  auto mapping_id = (int) (packed >> (PACKED_BANK_BITS + PACKED_ROW_BITS + PACKED_COL_BITS));
+  return {bank, row, col, mapping_id};
+}
+
+FlipRange FlipStore::add(const std::vector<BitFlip> &flips) {
+  FlipRange range { (uint32_t) size(), (uint32_t) flips.size() };
+  if (flips.empty()) {
+    return range;
+  }
+  if (size() == 0) {
+    epoch = flips.front().observation_time;
+  }
+
+  // the columns grow geometrically through push_back; reserving the exact size would copy them on every call
+  for (const auto &flip : flips) {
+    addresses.push_back(pack(flip.address));
+    bitmasks.push_back(flip.bitmask);
+    corrupted_data.push_back(flip.corrupted_data);
+    time_deltas.push_back(flip.observation_time > epoch ? (uint32_t) (flip.observation_time - epoch) : 0);
+  }
+  return range;
+}
+
+BitFlip FlipStore::at(size_t idx) const {
+  BitFlip flip(unpack(addresses[idx]), bitmasks[idx], corrupted_data[idx]);
+  flip.observation_time = epoch + time_deltas[idx];
+  return flip;
+}
+
+std::vector<BitFlip> FlipStore::get_flips(const FlipRange &range) const {
+  std::vector<BitFlip> flips;
+  flips.reserve(range.count);
+  for (size_t i = range.begin; i < range.end(); i++) {
+    flips.push_back(at(i));
+  }
+  return flips;
+}
+
+size_t FlipStore::count_bit_corruptions(const FlipRange &range) const {
+  size_t count = 0;
+  for (size_t i = range.begin; i < range.end(); i++) {
+    count += __builtin_popcount(bitmasks[i]);
+  }
+  return count;
+}
+
+size_t FlipStore::memory_usage() const {
+  return addresses.capacity()*sizeof(uint64_t)
+      + bitmasks.capacity()*sizeof(uint8_t)
+      + corrupted_data.capacity()*sizeof(uint8_t)
+      + time_deltas.capacity()*sizeof(uint32_t);
+}
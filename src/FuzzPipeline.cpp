@@ -0,0 +1,59 @@
+#include "FuzzPipeline.hpp"
+#include "PatternAddressMapper.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+FuzzPipeline::FuzzPipeline(HammerSuite &suite, const Args &args, int cpu)
+    : suite(suite), args(args), cpu(cpu), producer(&FuzzPipeline::produce, this) {
+}
+
+FuzzPipeline::~FuzzPipeline() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  slot_changed.notify_all();
+  producer.join();
+}
+
+void FuzzPipeline::produce() {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)) {
+    printf("unable to pin the pattern producer to cpu %d.\n", cpu);
+  }
+
+  // the random engines of the pattern builders are only used by this thread while the pipeline runs, the engines of
+  // PatternAddressMapper are per thread and need to be seeded for this one.
+  if(args.seed > 0) {
+    PatternAddressMapper::set_seed(args.seed + 1);
+  }
+
+  while(true) {
+    PreparedRound round = suite.prepare_round(args, true);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    slot_changed.wait(lock, [this] { return stopped || !slot.has_value(); });
+    if(stopped) {
+      return;
+    }
+    slot = std::move(round);
+    lock.unlock();
+    slot_changed.notify_all();
+  }
+}
+
+PreparedRound FuzzPipeline::next() {
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex);
+  slot_changed.wait(lock, [this] { return slot.has_value(); });
+  wait_time += std::chrono::steady_clock::now() - start;
+
+  PreparedRound round = std::move(*slot);
+  slot.reset();
+  lock.unlock();
+  slot_changed.notify_all();
+  return round;
+}
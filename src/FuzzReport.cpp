@@ -1,20 +1,25 @@
 #include "FuzzReport.hpp"
 #include "FuzzingParameterSet.hpp"
 #include "LocationReport.hpp"
+#include <span>
 #include <vector>
 
-std::vector<LocationReport> FuzzReport::get_reports() {
+std::span<const LocationReport> FuzzReport::get_reports() const {
   return reports;
 }
 
-size_t FuzzReport::sum_flips() {
+size_t FuzzReport::sum_flips() const {
   size_t sum = 0;
-  for(auto report : reports) {
+  for(auto& report : reports) {
     sum += report.sum_flips();
   }
   return sum;
 }
 
-void FuzzReport::add_report(LocationReport report) {
-  reports.push_back(report);
+void FuzzReport::add_report(LocationReport &&report) {
+  reports.push_back(std::move(report));
+}
+
+void FuzzReport::reserve(size_t locations) {
+  reports.reserve(locations);
 }
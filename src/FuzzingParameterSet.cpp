@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstdio>
 #include <random>
 #include <sstream>
 
@@ -101,6 +102,28 @@ void FuzzingParameterSet::set_fixed_acts_per_trefi(int fixed_acts_per_trefi) {
   this->fixed_acts_per_trefi = fixed_acts_per_trefi;
 }
 
+void FuzzingParameterSet::set_act_budget(int acts_per_trefi) {
+  // REF interval: 7.8 μs (tREFI), retention time: 64 ms => 8192 REFs per refresh window
+  constexpr int REFS_PER_REFRESH_WINDOW = 8192;
+
+  // fewer than 2 ACTs leave no (even) ACTs per tREFI to build a pattern from, e.g., after a failed measurement
+  if (acts_per_trefi < 2) {
+    printf("measured %d ACTs per tREFI, falling back to random fuzzing parameters.\n", acts_per_trefi);
+    randomize_parameters(false);
+    return;
+  }
+
+  num_activations_per_tREFI = acts_per_trefi - (acts_per_trefi % 2);
+  amplitude = Range<int>(1, num_activations_per_tREFI);
+  total_acts_pattern = num_activations_per_tREFI*num_refresh_intervals;
+  base_period = get_random_even_divisior(total_acts_pattern, 4);
+
+  // num_refresh_intervals divides REFS_PER_REFRESH_WINDOW, hence the pattern also ends with each window; hammer for
+  // about as many ACTs as for a random ACTs/tREFI value
+  const int acts_per_window = num_activations_per_tREFI*REFS_PER_REFRESH_WINDOW;
+  hammering_total_num_activations = std::max(1, 5000000/acts_per_window)*acts_per_window;
+}
+
 void FuzzingParameterSet::randomize_parameters(bool print) {
   // pick either the specified fixed ACTs/tREFI value, or randomly generate one.
   if (fixed_acts_per_trefi > 0) {
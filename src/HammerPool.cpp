@@ -0,0 +1,92 @@
+#include "HammerPool.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <immintrin.h>
+#include <x86intrin.h>
+#include <pthread.h>
+#include <sched.h>
+
+// the number of spin iterations before a waiting worker goes to sleep
+static constexpr size_t SPIN_ITERATIONS = 1 << 14;
+
+uint64_t StartDeadline::arrive_and_wait() {
+  uint32_t tsc_aux;
+  if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == num_threads) {
+    deadline.store(__rdtscp(&tsc_aux) + margin, std::memory_order_release);
+  }
+  uint64_t target;
+  while ((target = deadline.load(std::memory_order_acquire)) == 0) {
+    _mm_pause();
+  }
+  uint64_t now;
+  while ((now = __rdtscp(&tsc_aux)) < target) {
+    _mm_pause();
+  }
+  return now;
+}
+
+HammerPool::HammerPool(std::vector<int> cpus) : cpus(std::move(cpus)) {
+  workers.reserve(this->cpus.size());
+  for (size_t i = 0; i < this->cpus.size(); i++) {
+    workers.emplace_back(&HammerPool::work, this, i, this->cpus[i]);
+  }
+}
+
+HammerPool::~HammerPool() {
+  stopping = true;
+  generation.fetch_add(1, std::memory_order_release);
+  generation.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void HammerPool::run(std::vector<Task> &batch) {
+  if (batch.size() > workers.size()) {
+    printf("cannot run %lu tasks on %lu hammering threads.\n", batch.size(), workers.size());
+    exit(EXIT_FAILURE);
+  }
+
+  tasks = &batch;
+  remaining.store(workers.size(), std::memory_order_relaxed);
+  generation.fetch_add(1, std::memory_order_release);
+  generation.notify_all();
+
+  size_t left;
+  while ((left = remaining.load(std::memory_order_acquire)) != 0) {
+    remaining.wait(left, std::memory_order_acquire);
+  }
+  tasks = nullptr;
+}
+
+void HammerPool::work(size_t idx, int cpu) {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)) {
+    printf("unable to set affinity to %d\n.", cpu);
+    exit(1);
+  }
+  sched_yield();
+
+  uint64_t seen = 0;
+  while (true) {
+    // the next batch usually follows right after the memory check, hence spin for a short while before sleeping
+    for (size_t i = 0; i < SPIN_ITERATIONS && generation.load(std::memory_order_acquire) == seen; i++) {
+      _mm_pause();
+    }
+    generation.wait(seen, std::memory_order_acquire);
+    seen = generation.load(std::memory_order_acquire);
+
+    if (stopping) {
+      return;
+    }
+    if (idx < tasks->size()) {
+      (*tasks)[idx]();
+    }
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      remaining.notify_one();
+    }
+  }
+}
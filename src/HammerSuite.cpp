@@ -1,6 +1,5 @@
 #include "HammerSuite.hpp"
 #include <algorithm>
-#include <barrier>
 #include <cassert>
 #include <chrono>
 #include <cmath>
@@ -11,6 +10,7 @@
 #include <ctime>
 #include <emmintrin.h>
 #include <functional>
+#include <memory>
 #include <pthread.h>
 #include <random>
 #include <sched.h>
@@ -20,8 +20,13 @@
 #include <vector>
 #include <x86intrin.h>
 #include "CodeJitter.hpp"
+#include "CpuTopology.hpp"
 #include "DRAMConfig.hpp"
+#include "DramAnalyzer.hpp"
 #include "Enums.hpp"
+#include "FlipStore.hpp"
+#include "FuzzPipeline.hpp"
+#include "HammerPool.hpp"
 #include "FuzzReport.hpp"
 #include "FuzzingParameterSet.hpp"
 #include "HammeringPattern.hpp"
@@ -30,11 +35,16 @@
 #include "Memory.hpp"
 #include "PatternAddressMapper.hpp"
 #include "PatternBuilder.hpp"
+#include "RefPhaseTracker.hpp"
 #include "RefreshTimer.hpp"
 #include "Jitter.hpp"
+#include "JitCache.hpp"
+#include "JitRuntimePool.hpp"
 #include "SimplePatternBuilder.hpp"
 #include "CsvExporter.hpp"
 #define SYNC_TO_REF 0
+//how often check_calibration() looks for drift of the REF threshold
+#define DRIFT_CHECK_INTERVAL std::chrono::seconds(60)
 
 int start_thread = 6;
 const bool reproducibility_mode = false;
@@ -44,47 +54,141 @@ std::mt19937 HammerSuite::engine = std::mt19937(std::random_device()());
 HammerSuite::HammerSuite(Memory &memory) : memory(memory) {
 }
 
-void HammerSuite::set_seed(uint64_t seed){
-  engine = std::mt19937(seed);
+HammerPool &HammerSuite::get_hammer_pool(Args &args, size_t num_workers) {
+  auto cpus = CpuTopology::get().place(args.placement, std::max<size_t>(num_workers, args.threads), args.thread_start_id);
+  //the placement may differ between runs of an experiment matrix.
+  if(hammer_pool == nullptr || hammer_pool->get_cpus() != cpus) {
+    hammer_pool = std::make_unique<HammerPool>(cpus);
+  }
+  return *hammer_pool;
+}
+
+void HammerSuite::calibrate() {
+  profile = nullptr;
+  refresh_timer = std::make_unique<RefreshTimer>((volatile char *)DRAMAddr(0, 0, 0).to_virt());
+  DRAMConfig::get().set_sync_ref_threshold(refresh_timer->get_refresh_threshold());
+  last_drift_check = std::chrono::steady_clock::now();
+}
+
+void HammerSuite::calibrate(CalibrationProfile &profile) {
+  this->profile = &profile;
+  refresh_timer = std::make_unique<RefreshTimer>(
+    (volatile char *)DRAMAddr(0, 0, 0).to_virt(), 
+    profile.refresh_threshold, 
+    profile.cycles_per_refresh
+  );
+  DRAMConfig::get().set_sync_ref_threshold(refresh_timer->get_refresh_threshold());
+  last_drift_check = std::chrono::steady_clock::now();
+}
+
+void HammerSuite::check_calibration() {
+  if(refresh_timer == nullptr || std::chrono::steady_clock::now() - last_drift_check < DRIFT_CHECK_INTERVAL) {
+    return;
+  }
+  if(refresh_timer->drifted()) {
+    //rounds that were already prepared by the FuzzPipeline are still hammered with the previous threshold.
+    printf("the REF threshold drifted, recalibrating.\n");
+    refresh_timer->recalibrate();
+    DRAMConfig::get().set_sync_ref_threshold(refresh_timer->get_refresh_threshold());
+    RefPhaseTracker::get().set_threshold(refresh_timer->get_raw_refresh_threshold());
+    if(profile != nullptr) {
+      profile->refresh_threshold = refresh_timer->get_raw_refresh_threshold();
+      profile->cycles_per_refresh = refresh_timer->get_cycles_per_refresh();
+      profile->save();
+    }
+  }
+  last_drift_check = std::chrono::steady_clock::now();
 }
 
-size_t count_true_acts(std::vector<volatile char *> &pattern) {
-  size_t count = 0;
-  for(auto ptr : pattern) {
-    if(ptr != nullptr) {
-      count++;
+void HammerSuite::measure_act_budget(Args &args) {
+  //interleaved patterns are hammered by a single thread.
+  size_t threads = args.interleaved ? 1 : args.threads;
+  //the placement changes the ACT rate each thread reaches.
+  std::pair<size_t, std::string> key { threads, to_string(args.placement) };
+  if(profile != nullptr) {
+    auto it = profile->bank_acts_per_trefi.find(key);
+    if(it != profile->bank_acts_per_trefi.end() && it->second.size() == DRAMConfig::get().banks()) {
+      act_budget = it->second;
+      return;
+    }
+  }
+
+  //every bank is measured once by each thread, starting with bank b on thread 0 and bank b + i on thread i.
+  size_t banks = DRAMConfig::get().banks();
+  std::vector<uint64_t> sums(banks, 0);
+  std::vector<uint64_t> results(threads);
+  auto &pool = get_hammer_pool(args, threads);
+  printf("measuring the ACTs per tREFI of %lu banks with %lu threads (%s placement)...\n", banks, threads, key.second.c_str());
+  for(size_t b = 0; b < banks; b++) {
+    std::vector<HammerPool::Task> tasks;
+    for(size_t i = 0; i < threads; i++) {
+      size_t bank = (b + i) % banks;
+      tasks.emplace_back([&results, i, bank] {
+        results[i] = DramAnalyzer::count_acts_per_trefi(
+          (volatile char *)DRAMAddr(bank, 0, 0).to_virt(), 
+          (volatile char *)DRAMAddr(bank, 1, 0).to_virt()
+        );
+      });
+    }
+    pool.run(tasks);
+    for(size_t i = 0; i < threads; i++) {
+      sums[(b + i) % banks] += results[i];
     }
   }
-  return count;
+
+  act_budget.resize(banks);
+  printf("ACTs per tREFI:");
+  for(size_t bank = 0; bank < banks; bank++) {
+    act_budget[bank] = sums[bank] / threads;
+    printf(" %lu", act_budget[bank]);
+  }
+  printf("\n");
+
+  if(profile != nullptr) {
+    profile->bank_acts_per_trefi[key] = act_budget;
+    profile->save();
+  }
+}
+
+void HammerSuite::set_seed(uint64_t seed){
+  engine = std::mt19937(seed);
 }
 
-LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, Args &args) {
-  std::vector<std::thread> threads(patterns.size());
+LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, Args &args, std::vector<PatternIR> *exported) {
   std::vector<LocationReport> report;
   std::uniform_int_distribution shift_dist(2, 64);
   std::mt19937 rand(args.seed == 0 ? std::random_device()() : args.seed);
   size_t thread_id = args.thread_start_id;
-  RefreshTimer timer((volatile char *)DRAMAddr(0, 0, 0).to_virt());
-  //store it in the DRAMConfig so it can be used by ZenHammers CodeJitter.
-  DRAMConfig::get().set_sync_ref_threshold(timer.get_refresh_threshold());
-
-  std::vector<std::vector<volatile char *>> exported_patterns;
-  bool first = true;
-  for(auto pattern : patterns) {
-    exported_patterns.push_back(
-      pattern.mapper.export_pattern(
-        pattern.pattern, 
-        first ? args.scheduling_policy_first_thread : args.scheduling_policy_other_threads
-      )
-    );
-    first = false;
-  } 
+  std::unique_ptr<RefreshTimer> location_timer;
+  if(refresh_timer == nullptr) {
+    location_timer = std::make_unique<RefreshTimer>((volatile char *)DRAMAddr(0, 0, 0).to_virt());
+    //store it in the DRAMConfig so it can be used by ZenHammers CodeJitter.
+    DRAMConfig::get().set_sync_ref_threshold(location_timer->get_refresh_threshold());
+  }
+  RefreshTimer &timer = refresh_timer != nullptr ? *refresh_timer : *location_timer;
 
-  std::vector<std::chrono::time_point<std::chrono::steady_clock>> starts(patterns.size());
-  std::vector<std::chrono::time_point<std::chrono::steady_clock>> ends(patterns.size());
+  std::vector<PatternIR> exported_patterns;
+  if(exported != nullptr) {
+    exported_patterns = std::move(*exported);
+  } else {
+    bool first = true;
+    for(auto &pattern : patterns) {
+      pattern.mapper.get_code_jitter().emitter = args.jit_emitter;
+      pattern.mapper.get_code_jitter().sync_mode = args.sync_mode;
+      exported_patterns.push_back(
+        pattern.mapper.export_pattern(
+          pattern.pattern, 
+          first ? args.scheduling_policy_first_thread : args.scheduling_policy_other_threads
+        )
+      );
+      first = false;
+    }
+  }
+
+  std::vector<HammerTiming> timings(patterns.size());
 
   if(args.interleaved) {
-    std::vector<volatile char *> final_pattern = PatternAddressMapper::interleave(
+    PatternIR final_pattern = PatternAddressMapper::interleave(
       exported_patterns, 
       args.interleaving_chunk_size, 
       args.interleaving_distance,
@@ -95,8 +199,8 @@ LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, A
     int original_acts = patterns[0].params.get_hammering_total_num_activations();
     if(args.compensate_access_count) {
 
-      size_t final_pattern_true_acts = count_true_acts(final_pattern);
-      size_t main_pattern_true_acts = count_true_acts(exported_patterns[0]);
+      size_t final_pattern_true_acts = final_pattern.num_accesses();
+      size_t main_pattern_true_acts = exported_patterns[0].num_accesses();
 
       size_t diff = final_pattern_true_acts - main_pattern_true_acts;
       if(diff != 0) {
@@ -110,11 +214,8 @@ LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, A
     }
 
     DRAMAddr first_addr(0, 0, 0);
-    for(auto ptr : exported_patterns[0]) {
-      if(ptr == nullptr) {
-        continue;
-      }
-      first_addr = DRAMAddr((void *)ptr);
+    if(exported_patterns[0].last_access() != nullptr) {
+      first_addr = DRAMAddr((void *)exported_patterns[0].last_access());
     }
     printf("starting interleaved pattern on main bank %lu with starting address %s.\n",
            first_addr.actual_bank(), 
@@ -126,25 +227,29 @@ LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, A
       non_accessed_rows.insert(non_accessed_rows.end(), rows.begin(), rows.end());
     }
 
-    std::barrier fake_barrier(1);
+    StartDeadline start(1);
     CodeJitter jitter;
+    jitter.emitter = args.jit_emitter;
+    jitter.sync_mode = args.sync_mode;
+
+    std::vector<HammerPool::Task> tasks;
+    tasks.emplace_back([&] {
+      hammer_fn(
+        thread_id, 
+        final_pattern, 
+        non_accessed_rows, 
+        jitter,
+        patterns[0].params, 
+        start,
+        timer,
+        args.fence_type,
+        timings[0]
+      );
+    });
+    get_hammer_pool(args, 1).run(tasks);
 
-    hammer_fn(
-      thread_id, 
-      final_pattern, 
-      non_accessed_rows, 
-      jitter,
-      patterns[0].params, 
-      fake_barrier,
-      timer,
-      args.fence_type,
-      starts[0],
-      ends[0]
-    );
-
-    for(int i = 1; i < starts.size(); i++) {
-      starts[i] = starts[0];
-      ends[i] = ends[0];
+    for(int i = 1; i < timings.size(); i++) {
+      timings[i] = timings[0];
     }
 
     //set it back so it can be calculated again in the following runs
@@ -153,59 +258,54 @@ LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, A
   } else {
 
     std::vector<std::vector<volatile char *>> non_accessed_rows(patterns.size());
-    std::barrier barrier(patterns.size());
+    StartDeadline start(patterns.size());
+    std::vector<HammerPool::Task> tasks;
 
     for(int i = 0; i < exported_patterns.size(); i++) {
       non_accessed_rows[i] = patterns[i].mapper.get_random_nonaccessed_rows(DRAMConfig::get().rows());
       DRAMAddr first_addr(0, 0, 0);
-      for(auto ptr : exported_patterns[i]) {
-        if(ptr == nullptr) {
-          continue;
-        }
-        first_addr = DRAMAddr((void *)ptr);
+      if(exported_patterns[i].last_access() != nullptr) {
+        first_addr = DRAMAddr((void *)exported_patterns[i].last_access());
       }
       printf("starting thread on bank %lu with first address being %s.\n", 
              first_addr.actual_bank(),
              first_addr.to_string().c_str());
-      threads[i] = std::thread(
-        &HammerSuite::hammer_fn, 
-        this, 
-        thread_id++, 
-        std::ref(exported_patterns[i]),
-        std::ref(non_accessed_rows[i]),
-        std::ref(patterns[i].mapper.get_code_jitter()),
-        std::ref(patterns[i].params),
-        std::ref(barrier), 
-        std::ref(timer),
-        args.fence_type,
-        std::ref(starts[i]),
-        std::ref(ends[i])
-      );
+      tasks.emplace_back([&, i, id = thread_id++] {
+        hammer_fn(
+          id, 
+          exported_patterns[i],
+          non_accessed_rows[i],
+          patterns[i].mapper.get_code_jitter(),
+          patterns[i].params,
+          start, 
+          timer,
+          args.fence_type,
+          timings[i]
+        );
+      });
     }
   
-    for(auto& thread : threads) {
-      thread.join();
-    }
+    get_hammer_pool(args, tasks.size()).run(tasks);
   }
 
   LocationReport locationReport;
   int total_flips = 0;
   for(int i = 0; i < patterns.size(); i++) {
-    //this MUST be done SINGLE-THREADED as multiple threads would constantly overwrite the seed of srand().
+    //the expected data is stateless now, but check_memory still stores its results in memory.flipped_bits.
     size_t flips = memory.check_memory(patterns[i].mapper, reproducibility_mode, true);
     if(!reproducibility_mode) {
       flips = 0;
       if(!patterns[i].mapper.bit_flips.empty()) {
-        for(auto flip : patterns[i].mapper.bit_flips.back()) {
-          flips += flip.count_bit_corruptions();
-        }
+        flips = FlipStore::get().count_bit_corruptions(patterns[i].mapper.bit_flips.back());
       }
     }
 
     PatternReport report {
       .pattern = patterns[i],
       .flips = flips,
-      .duration = ends[i] - starts[i],
+      .duration = timings[i].end - timings[i].start,
+      .start_tsc = timings[i].start_tsc,
+      .end_tsc = timings[i].end_tsc,
     };
 
     if(!reproducibility_mode) {
@@ -220,7 +320,7 @@ LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, A
              DRAMAddr((void *)*patterns[i].mapper.get_victim_rows().begin()).actual_bank());
     }
 
-    locationReport.add_report(report);
+    locationReport.add_report(std::move(report));
   }
 
   if(total_flips) {
@@ -228,12 +328,19 @@ LocationReport HammerSuite::fuzz_pattern(std::vector<MappedPattern> &patterns, A
   }
 
   printf("hammering took %lu us at most.\n", std::chrono::duration_cast<std::chrono::microseconds>(locationReport.duration()).count());
+  if(patterns.size() > 1 && !args.interleaved) {
+    printf("threads started within %lu cycles (%.2f us) and hammered concurrently for %.1f%% of the time.\n",
+           locationReport.start_skew(),
+           std::chrono::duration<float, std::micro>(locationReport.start_skew_time()).count(),
+           locationReport.overlap());
+  }
   printf("\n###########################################################################################\n\n");
 
   return locationReport;
 }
 
-std::vector<LocationReport> HammerSuite::fuzz_location(std::vector<MappedPattern> &patterns, size_t locations, Args &args) {
+std::vector<LocationReport> HammerSuite::fuzz_location(std::vector<MappedPattern> &patterns, size_t locations, Args &args,
+                                                       std::vector<PatternIR> *first_exported) {
   std::vector<LocationReport> location_reports(locations);
 
   if(locations == 0) {
@@ -241,18 +348,37 @@ std::vector<LocationReport> HammerSuite::fuzz_location(std::vector<MappedPattern
     exit(1);
   }
 
-  location_reports[0] = fuzz_pattern(patterns, args);
-  if(--locations == 0) {
-    return location_reports;
+  //shifting a pattern only changes its addresses, so its hammering function is patched instead of re-assembled.
+  for(auto &pattern : patterns) {
+    pattern.mapper.get_code_jitter().relocatable = locations > 1;
   }
 
-  for(int i = 0; i < locations; i++) {
+  location_reports[0] = fuzz_pattern(patterns, args, first_exported);
+
+  //with several mappings, consecutive locations also move to the next mapping (superpage).
+  auto num_mappings = DRAMAddr::num_mappings();
+  for(int i = 0; i < locations - 1; i++) {
     for(int j = 0; j < patterns.size(); j++) {
       patterns[j].mapper.shift_mapping(14, {});
+      if(num_mappings > 1) {
+        patterns[j].mapper.move_to_mapping((patterns[j].mapper.mapping_id + 1) % num_mappings);
+      }
     }
     location_reports[i + 1] = fuzz_pattern(patterns, args);
   }
 
+  size_t assemblies = 0, relocations = 0;
+  for(auto &pattern : patterns) {
+    auto &jitter = pattern.mapper.get_code_jitter();
+    assemblies += jitter.num_assemblies;
+    relocations += jitter.num_relocations;
+    jitter.relocatable = false;
+    jitter.cleanup();
+  }
+  if(relocations) {
+    printf("relocated %lu hammering functions, assembled %lu.\n", relocations, assemblies);
+  }
+
   return location_reports;
 }
 
@@ -281,11 +407,26 @@ std::vector<LocationReport> HammerSuite::fuzz_location(std::vector<HammeringPatt
 }
 
 FuzzReport HammerSuite::fuzz(Args &args) {
+  PreparedRound round = prepare_round(args, false);
+  return run_round(round, args);
+}
+
+PreparedRound HammerSuite::prepare_round(Args &args, bool jit) {
   FuzzingParameterSet parameters;
   parameters.set_interleaved(args.interleaved);
   parameters.randomize_parameters();
   std::vector<HammeringPattern> fuzz_patterns(args.threads);
 
+  //with a measured budget, each pattern is sized for the bank it will be mapped to (the banks are assigned in order).
+  std::vector<FuzzingParameterSet> budget_parameters;
+  if(!act_budget.empty()) {
+    for(size_t i = 0; i < args.threads; i++) {
+      size_t bank = (PatternAddressMapper::bank_counter + i) % act_budget.size();
+      budget_parameters.push_back(parameters);
+      budget_parameters.back().set_act_budget((int)act_budget[bank]);
+    }
+  }
+
   #define USE_RANDOM_PATTERN_GEN 0
   for(size_t i = 0; i < args.threads; i++) {
 #if USE_RANDOM_PATTERN_GEN
@@ -293,15 +434,57 @@ FuzzReport HammerSuite::fuzz(Args &args) {
     pattern = random_pattern_builder.create_advanced_pattern(rand() % 2048);
 #else
     fuzz_patterns[i] = generate_pattern(
-      parameters, 
+      budget_parameters.empty() ? parameters : budget_parameters[i], 
       args.simple_patterns_other_threads && i > 0 || args.simple_patterns_first_thread && i == 0, args.randomization_style);
 #endif
   }
 
+  PreparedRound round;
+  parameters = FuzzingParameterSet();
+  parameters.randomize_parameters();
+  for(int i = 0; i < fuzz_patterns.size(); i++) {
+    round.patterns.push_back(map_pattern(fuzz_patterns[i], parameters, i >= 1 && args.simple_patterns_other_threads || i == 0 && args.simple_patterns_first_thread, args.randomization_style));
+    //the pattern is hammered for the number of ACTs it was sized for.
+    if(!budget_parameters.empty()) {
+      round.patterns.back().params = budget_parameters[i];
+    }
+    if(args.randomize_each_pattern) {
+      parameters = FuzzingParameterSet();
+      parameters.randomize_parameters();
+    }
+  }
+
+  for(int i = 0; i < round.patterns.size(); i++) {
+    auto &pattern = round.patterns[i];
+    auto &jitter = pattern.mapper.get_code_jitter();
+    jitter.emitter = args.jit_emitter;
+    jitter.sync_mode = args.sync_mode;
+    jitter.relocatable = args.locations > 1;
+    round.exported.push_back(
+      pattern.mapper.export_pattern(
+        pattern.pattern,
+        i == 0 ? args.scheduling_policy_first_thread : args.scheduling_policy_other_threads
+      )
+    );
+    //interleaved patterns are combined into a single function right before hammering.
+    if(jit && !args.interleaved) {
+      jitter.jit_strict(pattern.params.flushing_strategy,
+                        pattern.params.fencing_strategy,
+                        round.exported.back(),
+                        args.fence_type,
+                        pattern.params.get_hammering_total_num_activations());
+    }
+  }
+
+  return round;
+}
+
+FuzzReport HammerSuite::run_round(PreparedRound &round, Args &args) {
   FuzzReport report;
+  report.reserve(args.locations);
   printf("running %hu patterns over %hu locations...\n", args.threads, args.locations);
-  for(auto location_report : fuzz_location(fuzz_patterns, args.locations, args)) {
-    report.add_report(location_report);
+  for(auto& location_report : fuzz_location(round.patterns, args.locations, args, &round.exported)) {
+    report.add_report(std::move(location_report));
   }
   printf("executed fuzzing run on %hu locations with %hu patterns, flipping %lu bits.\n", args.locations, args.threads, report.get_reports().back().sum_flips());
 
@@ -348,16 +531,17 @@ MappedPattern HammerSuite::build_mapped(FuzzingParameterSet &params, bool simple
   return map_pattern(pattern, params, simple, randomization_style);
 }
 
-std::vector<FuzzReport> HammerSuite::filter_and_analyze_flips(std::vector<FuzzReport> &patterns, std::string &filepath) {
+std::vector<const FuzzReport *> HammerSuite::filter_and_analyze_flips(const std::vector<FuzzReport> &patterns, std::string &filepath) {
   printf("\n##### BEGIN EFFECTIVE PATTERN ANALYSIS #####\n\n");
 
-  std::vector<FuzzReport> effective_reports;
+  // the effective reports are only referenced, they stay owned by patterns
+  std::vector<const FuzzReport *> effective_reports;
   size_t sum_flips = 0;
   for(auto& report : patterns) {
     size_t sum = report.sum_flips();
     sum_flips += sum;
     if(sum > 0) {
-      effective_reports.push_back(report);
+      effective_reports.push_back(&report);
     }  
   }
   printf("we flipped %lu bits over %lu fuzzing runs. We found %lu runs with at least one flip.\n", sum_flips, patterns.size(), effective_reports.size());
@@ -374,10 +558,10 @@ std::vector<FuzzReport> HammerSuite::filter_and_analyze_flips(std::vector<FuzzRe
   std::map<size_t, size_t> bank_effective_counts;
   std::map<size_t, size_t> bank_flip_counts;
 
-  for(auto& report : effective_reports) {
-    std::vector<LocationReport> final_reports = report.get_reports();
+  for(auto report : effective_reports) {
+    auto final_reports = report->get_reports();
     int location = 0;
-    for(auto final_report: final_reports) {
+    for(auto& final_report: final_reports) {
       location++;
       int threads = final_report.get_reports().size();
       if(final_report.sum_flips() > 0) {
@@ -450,24 +634,25 @@ std::vector<FuzzReport> HammerSuite::filter_and_analyze_flips(std::vector<FuzzRe
 
     printf("we found bitflip information on at least one pattern. Running analysis...\n");
     for(int r = 0; r < effective_reports.size(); r++) {
-      auto loc_reports = effective_reports[r].get_reports();
+      auto loc_reports = effective_reports[r]->get_reports();
       for(int loc = 0; loc < loc_reports.size(); loc++) {
         bool effective = false;
         auto patterns = loc_reports[loc].get_reports();
         int threads = patterns.size();
         for(int p = 0; p < patterns.size(); p++) {
-          auto pat = patterns[p];
+          auto& pat = patterns[p];
           std::set<size_t> banks;
-          for(auto& flip : pat.bit_flips) {
-            exporter.export_flip(
-              flip, 
-              r, 
-              loc, 
-              p,
-              threads, 
-              pat.pattern.mapper.aggressor_to_addr.size(), 
-              pat.pattern.pattern.aggressors.size(),
-              pat.duration);
+          auto flips = FlipStore::get().get_flips(pat.bit_flips);
+          exporter.export_flips(
+            flips,
+            r,
+            loc,
+            p,
+            threads,
+            pat.pattern.mapper.aggressor_to_addr.size(),
+            pat.pattern.pattern.aggressors.size(),
+            pat.duration);
+          for(auto& flip : flips) {
             banks.insert(flip.address.actual_bank());
             int z = flip.count_o2z_corruptions();
             int o = flip.count_z2o_corruptions();
@@ -503,17 +688,16 @@ std::vector<FuzzReport> HammerSuite::filter_and_analyze_flips(std::vector<FuzzRe
 void HammerSuite::check_effective_patterns(std::vector<FuzzReport> &patterns, Args &args) {
   std::vector<FuzzReport> fuzz_reports;
   std::string path("bit_flips_search.csv");
-  std::vector<FuzzReport> effective_reports = filter_and_analyze_flips(patterns, path);
+  std::vector<const FuzzReport *> effective_reports = filter_and_analyze_flips(patterns, path);
   std::vector<FuzzReport> comparison_reports;
 
   std::vector<MappedPattern> effective_patterns;
-  for(auto& report : effective_reports) {
-    for(auto location_report : report.get_reports()) {
+  for(auto report : effective_reports) {
+    for(auto& location_report : report->get_reports()) {
       for(auto& p : location_report.get_reports()) {
         if(p.flips > 0) {
           effective_patterns.push_back(p.pattern);
         }
-        p.pattern.mapper.bit_flips.clear();
       }
       if(!args.test_effective_patterns_random) {
         continue;
@@ -526,16 +710,16 @@ void HammerSuite::check_effective_patterns(std::vector<FuzzReport> &patterns, Ar
       }
       std::vector<LocationReport> location_reports = fuzz_location(cloned_patterns, args.fuzz_locations, args);
       for(int i = 0; i < location_reports.size(); i++) {
-        single_report.add_report(location_reports[i]);
+        single_report.add_report(std::move(location_reports[i]));
       }
-      comparison_reports.push_back(single_report);
+      comparison_reports.push_back(std::move(single_report));
 
       //check from 1 to 8 threads
       for(int threads = 1; threads <= 8; threads++) {
         FuzzReport fuzzing_run_report;
         std::vector<MappedPattern> patterns;
         std::set<size_t> banks;
-        std::vector<PatternReport> pattern_reports = location_report.get_reports();
+        auto pattern_reports = location_report.get_reports();
         for(int i = 0; i < pattern_reports.size() && i < threads; i++) {
           patterns.push_back(pattern_reports[i].pattern);
           banks.insert(pattern_reports[i].pattern.mapper.bank_no);
@@ -568,9 +752,9 @@ void HammerSuite::check_effective_patterns(std::vector<FuzzReport> &patterns, Ar
         std::vector<LocationReport> final_reports = fuzz_location(patterns, args.fuzz_locations, args);
         
         for(int j = 0; j < final_reports.size(); j++) {
-          fuzzing_run_report.add_report(final_reports[j]);
+          fuzzing_run_report.add_report(std::move(final_reports[j]));
         }
-        fuzz_reports.push_back(fuzzing_run_report);
+        fuzz_reports.push_back(std::move(fuzzing_run_report));
       }
     }
   }
@@ -622,9 +806,9 @@ void HammerSuite::check_effective_patterns(std::vector<FuzzReport> &patterns, Ar
       
       FuzzReport fuzzing_run_report;
       for(int j = 0; j < final_reports.size(); j++) {
-        fuzzing_run_report.add_report(final_reports[j]);
+        fuzzing_run_report.add_report(std::move(final_reports[j]));
       }
-      fuzz_reports.push_back(fuzzing_run_report);
+      fuzz_reports.push_back(std::move(fuzzing_run_report));
     }
 
     effective_patterns.erase(effective_patterns.begin());
@@ -640,30 +824,106 @@ std::vector<FuzzReport> HammerSuite::auto_fuzz(Args args) {
   std::vector<FuzzReport> reports;
   auto start = std::chrono::steady_clock::now();
   auto max_duration = std::chrono::seconds(args.runtime_limit);
+
+  //prepare the next round on a core that is not used for hammering while the current one is hammered.
+  std::unique_ptr<FuzzPipeline> pipeline;
+  bool calibrated_here = false;
+  //all rounds are jitted ahead of time for the same sync REF threshold, so it is only calibrated once. The REF
+  //tracker needs the threshold as well.
+  if((args.pipeline || args.sync_mode == SYNC_MODE::PREDICTED) && refresh_timer == nullptr) {
+    calibrate();
+    calibrated_here = true;
+  }
+  act_budget.clear();
+  if(args.measured_acts) {
+    measure_act_budget(args);
+  }
+  auto &topology = CpuTopology::get();
+  auto used_cpus = topology.place(args.placement, args.threads, args.thread_start_id);
+  int pipeline_cpu = -1;
+  if(args.pipeline) {
+    pipeline_cpu = topology.helper_cpu(used_cpus);
+    used_cpus.push_back(pipeline_cpu);
+  }
+  //the tracker is started first, as the pipeline already jits rounds with the sync mode.
+  if(args.sync_mode == SYNC_MODE::PREDICTED) {
+    bool locked = RefPhaseTracker::get().start(
+      topology.helper_cpu(used_cpus), 
+      (volatile char *)DRAMAddr(0, 0, 0).to_virt(), 
+      refresh_timer->get_raw_refresh_threshold()
+    );
+    if(!locked) {
+      printf("[WARN] falling back to probing for REF.\n");
+      args.sync_mode = SYNC_MODE::PROBE;
+    }
+  }
+  if(args.pipeline) {
+    printf("preparing fuzzing rounds on cpu %d.\n", pipeline_cpu);
+    pipeline = std::make_unique<FuzzPipeline>(*this, args, pipeline_cpu);
+  }
+
   while(std::chrono::steady_clock::now() - start < max_duration) {
-    reports.push_back(fuzz(args));
+    check_calibration();
+    if(pipeline != nullptr) {
+      PreparedRound round = pipeline->next();
+      reports.push_back(run_round(round, args));
+    } else {
+      reports.push_back(fuzz(args));
+    }
     printf("managed to flip %lu bits over %lu reports.\n", reports.back().sum_flips(), reports.back().get_reports().size());
   }
+  auto wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+  double waited = 0;
+  if(pipeline != nullptr) {
+    waited = std::chrono::duration<double>(pipeline->get_wait_time()).count();
+    pipeline.reset();
+  }
+  if(calibrated_here) {
+    refresh_timer.reset();
+  }
 
   printf("stopping fuzzer since maximum duration of %lu seconds has passed. (%f)\n", 
          max_duration.count(),
-         std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+         wall_time.count());
+
+  double hammer_time = 0;
+  for(const auto &report : reports) {
+    for(const auto &location_report : report.get_reports()) {
+      hammer_time += location_report.duration().count();
+    }
+  }
+  printf("fuzzing duty cycle: %.1f%% (%.1f s hammering in %.1f s).\n",
+         100 * hammer_time / wall_time.count(), hammer_time, wall_time.count());
+  if(args.pipeline) {
+    printf("waited %.1f s for prepared rounds.\n", waited);
+  }
+  printf("the flip store holds %zu flips in %zu bytes.\n", FlipStore::get().size(), FlipStore::get().memory_usage());
+  printf("created %zu JIT runtimes for all hammering runs.\n", JitRuntimePool::get().num_created());
+  printf("JIT cache: %zu hits, %zu misses.\n", JitCache::get().get_hits(), JitCache::get().get_misses());
 
   check_effective_patterns(reports, args);
 
+  //the effective patterns are jitted with the same sync mode.
+  if(args.sync_mode == SYNC_MODE::PREDICTED) {
+    auto &tracker = RefPhaseTracker::get();
+    tracker.stop();
+    printf("REF tracker: observed %lu edges, missed %lu, sync error %.0f cycles on average (max. %lu).\n",
+           tracker.get_edges(), tracker.get_missed(), tracker.get_mean_sync_error(), tracker.get_max_sync_error());
+  }
+
   return reports;
 }
 
 void HammerSuite::hammer_fn(size_t id,
-                            std::vector<volatile char *> &pattern,
+                            PatternIR &pattern,
                             std::vector<volatile char *> &non_accessed_rows,
                             CodeJitter &jitter,
                             FuzzingParameterSet &params,
-                            std::barrier<> &start_barrier, 
+                            StartDeadline &start, 
                             RefreshTimer &timer,
                             FENCE_TYPE fence_type,
-                            std::chrono::time_point<std::chrono::steady_clock> &start,
-                            std::chrono::time_point<std::chrono::steady_clock> &end) {
+                            HammerTiming &timing) {
 #define USE_ZEN_JITTER 1
 
 #if USE_ZEN_JITTER
@@ -681,29 +941,22 @@ void HammerSuite::hammer_fn(size_t id,
     *non_accessed_rows[i % (non_accessed_rows.size() - 1)];
   }
 
-  auto self = pthread_self();
-  cpu_set_t cpuset;
-  CPU_ZERO(&cpuset);
-  CPU_SET(id % 16, &cpuset);
-  int rc = pthread_setaffinity_np(self, sizeof(cpu_set_t), &cpuset);
-  if(rc) {
-    printf("unable to set affinity to %lu\n.", id % 16);
-    exit(1);
-  }
-  sched_yield();
-
+  //the calling HammerPool worker is already pinned to its CPU (see CpuTopology::place).
   printf("thread %lu is starting a hammering run for %lu addresses.\n", id, pattern.size());
-  start_barrier.arrive_and_wait();
-  start = std::chrono::steady_clock::now();
+  timing.start_tsc = start.arrive_and_wait();
+  timing.start = std::chrono::steady_clock::now();
 #if SYNC_TO_REF
-  timer.wait_for_refresh(DRAMAddr((void *)pattern[0]).actual_bank());
+  timer.wait_for_refresh(DRAMAddr((void *)pattern.first_access()).actual_bank());
 #endif
 #if USE_ZEN_JITTER
   jitter.hammer_pattern(params, true);
-  jitter.cleanup();
+  if(!jitter.relocatable) {
+    jitter.cleanup();
+  }
 #else
-  size_t timing = fn();
-  printf("thread %lu took %lu cycles\n", id, timing);
+  size_t cycles = fn();
+  printf("thread %lu took %lu cycles\n", id, cycles);
 #endif
-  end = std::chrono::steady_clock::now();
+  timing.end_tsc = RefreshTimer::current_timestamp();
+  timing.end = std::chrono::steady_clock::now();
 }
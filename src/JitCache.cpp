@@ -0,0 +1,79 @@
+#include "JitCache.hpp"
+#include "CodeJitter.hpp"
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+static inline size_t hash_combine(size_t seed, uint64_t value) {
+  // splitmix64 finalizer to spread the (mostly page-aligned) addresses over all bits
+  value += 0x9e3779b97f4a7c15ULL;
+  value = (value ^ (value >> 30))*0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27))*0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+size_t JitCacheKeyHash::operator()(const JitCacheKey &key) const {
+  size_t h = key.pattern.size();
+  for (const auto &op : key.pattern) {
+    h = hash_combine(h, (uint64_t) op.type);
+    h = hash_combine(h, (uint64_t) op.addr);
+  }
+  h = hash_combine(h, (uint64_t) key.flushing);
+  h = hash_combine(h, (uint64_t) key.fencing);
+  h = hash_combine(h, (uint64_t) key.fence_type);
+  h = hash_combine(h, (uint64_t) key.total_num_activations);
+  h = hash_combine(h, key.sync_ref_threshold);
+  h = hash_combine(h, (uint64_t) key.emitter);
+  h = hash_combine(h, (uint64_t) key.sync_mode);
+  return h;
+}
+
+JitCacheEntry::~JitCacheEntry() {
+  if (fn != nullptr) {
+    runtime->release(fn);
+  }
+}
+
+JitCache &JitCache::get() {
+  static JitCache instance;
+  return instance;
+}
+
+std::shared_ptr<JitCacheEntry> JitCache::lookup(const JitCacheKey &key) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    misses++;
+    return nullptr;
+  }
+  hits++;
+  lru.splice(lru.begin(), lru, it->second);
+  return it->second->second;
+}
+
+std::shared_ptr<JitCacheEntry> JitCache::insert(JitCacheKey key, asmjit::CodeHolder &holder) {
+  auto entry = std::make_shared<JitCacheEntry>();
+  entry->runtime = &runtime;
+  entry->code_size = holder.codeSize();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  asmjit::Error err = runtime.add(&entry->fn, &holder);
+  if (err) throw std::runtime_error("[-] Error occurred while jitting code. Aborting execution!");
+
+  // another thread may have jitted the same function concurrently, keep the one that is already cached
+  auto it = entries.find(key);
+  if (it != entries.end()) {
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->second;
+  }
+
+  lru.emplace_front(std::move(key), entry);
+  entries.emplace(lru.front().first, lru.begin());
+  if (lru.size() > MAX_ENTRIES) {
+    entries.erase(lru.back().first);
+    lru.pop_back();
+  }
+  return entry;
+}
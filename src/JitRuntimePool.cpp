@@ -0,0 +1,44 @@
+#include "JitRuntimePool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <mutex>
+
+JitRuntimePool &JitRuntimePool::get() {
+  static JitRuntimePool instance;
+  return instance;
+}
+
+asmjit::JitRuntime *JitRuntimePool::acquire() {
+  std::lock_guard<std::mutex> lock(mutex);
+  in_use++;
+  if (!idle.empty()) {
+    auto *runtime = idle.back().release();
+    idle.pop_back();
+    return runtime;
+  }
+  created++;
+  return new asmjit::JitRuntime;
+}
+
+void JitRuntimePool::release(asmjit::JitRuntime *runtime) {
+  if (runtime == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  assert(in_use > 0 && "A runtime was released more often than runtimes were acquired.");
+  assert(std::none_of(idle.begin(), idle.end(), [runtime](const auto &r) { return r.get() == runtime; })
+         && "A runtime was released twice.");
+  in_use--;
+  if (idle.size() < MAX_IDLE_RUNTIMES) {
+    idle.emplace_back(runtime);
+  } else {
+    delete runtime;
+  }
+}
+
+size_t JitRuntimePool::num_created() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return created;
+}
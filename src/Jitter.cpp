@@ -5,7 +5,6 @@
 #include "asmjit/x86/x86assembler.h"
 #include "asmjit/x86/x86operand.h"
 #include <cstdint>
-#include <set>
 #include <vector>
 
 const size_t SERIALIZE_EACH_N = 16;
@@ -57,23 +56,19 @@ void Jitter::jit_ref_sync(asmjit::x86::Assembler &assembler, DRAMAddr sync_bank)
   assembler.pop(asmjit::x86::rdi);
 }
 
-HammerFunc Jitter::jit(std::vector<volatile char *> &addresses, std::vector<volatile char *> &non_accessed_rows, size_t acts, bool sync_each_iteration) {
+HammerFunc Jitter::jit(const PatternIR &pattern, std::vector<volatile char *> &non_accessed_rows, size_t acts, bool sync_each_iteration) {
   asmjit::CodeHolder h;
   h.init(rt.environment(), rt.cpuFeatures());
   asmjit::x86::Assembler assembler(&h);
 
-  std::set<volatile char *> used_ptrs;
-
-  used_ptrs.insert(addresses.front()); 
+  //addresses are flushed right before they are accessed again
+  PatternIR loop = pattern.make_loop(FLUSHING_STRATEGY::LATEST_POSSIBLE, FENCING_STRATEGY::OMIT_FENCING);
 
   assembler.mov(asmjit::x86::rsi, 0);
   jit_ref_sync(assembler, DRAMAddr((void *)non_accessed_rows.back()));
 
   auto loop_start = assembler.newLabel();
   assembler.bind(loop_start);
-  if(sync_each_iteration) {
-    jit_ref_sync(assembler, DRAMAddr((void *)non_accessed_rows.back()));
-  }
 
   //get the current timestamp and push it to the stack
   assembler.mfence();
@@ -83,41 +78,40 @@ HammerFunc Jitter::jit(std::vector<volatile char *> &addresses, std::vector<vola
   assembler.or_(asmjit::x86::rdx, asmjit::x86::rax);
   assembler.mov(asmjit::x86::r10, asmjit::x86::rdx);
 
-  bool should_fence = true;
-  for(int j = 0; j < addresses.size(); j++) {
-    if(addresses[j] == nullptr) {
-      if(should_fence) {
+  size_t j = 0;
+  for(const auto &op : loop) {
+    switch(op.type) {
+      case PatternOpType::ACCESS:
+        //move the pointer to rax
+        assembler.mov(asmjit::x86::rax, (uint64_t)op.addr);
+        //serialize instructions on every nth access;
+        if(j++ % SERIALIZE_EACH_N == 1) {
+          assembler.mfence();
+        }
+        //dereference the pointer, causing a memory access
+        assembler.mov(asmjit::x86::rcx, asmjit::x86::ptr(asmjit::x86::rax));
+        assembler.inc(asmjit::x86::rsi);
+        break;
+      case PatternOpType::FLUSH:
+        //flush the corresponding line from the cache
+        assembler.mov(asmjit::x86::rax, (uint64_t)op.addr);
+        assembler.clflushopt(asmjit::x86::ptr(asmjit::x86::rax));
+        break;
+      case PatternOpType::FENCE:
         assembler.mfence();
-        should_fence = false;
-      } else {
-        assembler.nop();
-      }
-      assembler.nop();
-      continue;
-    }
-    should_fence = true;
-    //move the pointer to rax
-    assembler.mov(asmjit::x86::rax, (uint64_t)addresses[j]);
-    //we only need to flush addresses which have already been accessed
-    bool flushed = false;
-    if(used_ptrs.contains(addresses[j])) {
-      //flush the corresponding line from the cache
-      assembler.clflushopt(asmjit::x86::ptr(asmjit::x86::rax));
-    } else {
-      used_ptrs.insert(addresses[j]);
+        break;
+      case PatternOpType::SYNC:
+        if(sync_each_iteration) {
+          jit_ref_sync(assembler, DRAMAddr((void *)non_accessed_rows.back()));
+        }
+        break;
+      case PatternOpType::LOOP_BACK:
+        assembler.cmp(asmjit::x86::rsi, acts);
+        assembler.jb(loop_start);
+        break;
     }
-    //serialize instructions on every nth access;
-    if(j % SERIALIZE_EACH_N == 1) {
-      assembler.mfence();
-    }
-    //dereference the pointer, causing a memory access
-    assembler.mov(asmjit::x86::rcx, asmjit::x86::ptr(asmjit::x86::rax));
-    assembler.inc(asmjit::x86::rsi);
   }
 
-  assembler.cmp(asmjit::x86::rsi, acts);
-  assembler.jb(loop_start);
-
   //get another timestamp
   assembler.mfence();
   assembler.rdtscp();
@@ -1,25 +1,27 @@
 #include "LocationReport.hpp"
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
+#include <span>
 #include <vector>
 
-std::vector<PatternReport> LocationReport::get_reports() {
+std::span<const PatternReport> LocationReport::get_reports() const {
   return reports;
 }
 
-size_t LocationReport::sum_flips() {
+size_t LocationReport::sum_flips() const {
   size_t sum = 0;
-  for(auto report : reports) {
+  for(auto& report : reports) {
     sum += report.flips;
   }
   return sum;
 }
 
-void LocationReport::add_report(PatternReport report) {
-  reports.push_back(report);
+void LocationReport::add_report(PatternReport &&report) {
+  reports.push_back(std::move(report));
 }
 
-std::chrono::duration<float> LocationReport::duration() {
+std::chrono::duration<float> LocationReport::duration() const {
   std::chrono::duration<float> max = std::chrono::duration<float>::min();
   for(auto& report : reports) {
     if(report.duration > max) {
@@ -29,3 +31,44 @@ std::chrono::duration<float> LocationReport::duration() {
 
   return max;
 }
+
+uint64_t LocationReport::start_skew() const {
+  if(reports.empty()) {
+    return 0;
+  }
+  auto [first, last] = std::minmax_element(reports.begin(), reports.end(), [](auto &a, auto &b) {
+    return a.start_tsc < b.start_tsc;
+  });
+  return last->start_tsc - first->start_tsc;
+}
+
+std::chrono::duration<float> LocationReport::start_skew_time() const {
+  //the steady clock and the TSC were read at the same points, so their ratio gives the TSC rate.
+  float seconds = 0;
+  uint64_t cycles = 0;
+  for(auto& report : reports) {
+    seconds += report.duration.count();
+    cycles += report.end_tsc - report.start_tsc;
+  }
+  if(cycles == 0) {
+    return std::chrono::duration<float>::zero();
+  }
+  return std::chrono::duration<float>(start_skew() * seconds / cycles);
+}
+
+float LocationReport::overlap() const {
+  if(reports.empty()) {
+    return 0;
+  }
+  uint64_t first_start = UINT64_MAX, last_start = 0, first_end = UINT64_MAX, last_end = 0;
+  for(auto& report : reports) {
+    first_start = std::min(first_start, report.start_tsc);
+    last_start = std::max(last_start, report.start_tsc);
+    first_end = std::min(first_end, report.end_tsc);
+    last_end = std::max(last_end, report.end_tsc);
+  }
+  if(first_end <= last_start || last_end <= first_start) {
+    return 0;
+  }
+  return 100.0f * (first_end - last_start) / (last_end - first_start);
+}
@@ -1,14 +1,36 @@
 #include "Logger.hpp"
 #include <iostream>
 #include <GlobalDefines.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <mutex>
 
+// guards the list of rings (defined before the instance, which still uses it when it is destroyed)
+std::mutex mutex;
+
 // initialize the singleton instance
 Logger Logger::instance; /* NOLINT */
 
 Logger::Logger() = default;
 
-std::mutex mutex;
+// the instance is destroyed on exit(), which would terminate the process if the flusher thread was still running
+Logger::~Logger() {
+  if (flusher.joinable()) close();
+}
+
+// how long the flusher thread sleeps between draining the rings
+static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(1);
+
+struct BitflipFields {
+  volatile char *flipped_address;
+  uint64_t bank_no;
+  uint64_t row_no;
+  unsigned long timestamp;
+  unsigned char actual_value;
+  unsigned char expected_value;
+};
+static_assert(sizeof(BitflipFields) <= LogRecord::PAYLOAD_SIZE);
 
 void Logger::initialize() {
   instance.logfile = std::ofstream();
@@ -18,62 +40,168 @@ void Logger::initialize() {
   // we need to open the log file in append mode because the run_benchmark script writes values into it
   instance.logfile.open(logfile_filename, std::ios::out | std::ios::app);
   instance.timestamp_start = (unsigned long) time(nullptr);
+  instance.stopping = false;
+  instance.flusher = std::thread(&Logger::flush_loop, &instance);
 }
 
 void Logger::close() {
+  instance.stopping = true;
+  if (instance.flusher.joinable()) instance.flusher.join();
+  instance.flush_rings();
   instance.logfile << std::endl;
   instance.logfile.close();
 }
 
+LogRing &Logger::ring() {
+  thread_local std::shared_ptr<LogRing> local;
+  if (local == nullptr) {
+    local = std::make_shared<LogRing>();
+    std::lock_guard<std::mutex> lock(mutex);
+    instance.rings.push_back(local);
+  }
+  return *local;
+}
+
+void Logger::log_text(LogLevel level, const std::string &message, bool newline) {
+  auto &r = ring();
+  size_t num_records = std::max<size_t>(1, (message.size() + LogRecord::PAYLOAD_SIZE - 1)/LogRecord::PAYLOAD_SIZE);
+  if (r.reserve(0, num_records) == nullptr) {
+    r.drop();
+    return;
+  }
+  auto tsc = __builtin_ia32_rdtsc();
+  for (size_t i = 0; i < num_records; i++) {
+    auto *record = r.reserve(i, num_records);
+    auto offset = i*LogRecord::PAYLOAD_SIZE;
+    record->tsc = tsc;
+    record->render = nullptr;
+    record->format = nullptr;
+    record->level = level;
+    record->flags = (i == 0 ? LogRecord::FIRST : 0)
+        | (i + 1 == num_records ? LogRecord::LAST : 0)
+        | (newline ? LogRecord::NEWLINE : 0);
+    record->length = std::min(LogRecord::PAYLOAD_SIZE, message.size() - std::min(offset, message.size()));
+    if (record->length) std::memcpy(record->payload, message.data() + offset, record->length);
+  }
+  r.commit(num_records);
+}
+
+void Logger::flush_loop() {
+  while (!stopping) {
+    flush_rings();
+    std::this_thread::sleep_for(FLUSH_INTERVAL);
+  }
+}
+
+void Logger::flush_rings() {
+  std::vector<std::shared_ptr<LogRing>> current;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = rings;
+  }
+
+  std::vector<LogRecord> records;
+  size_t dropped = 0;
+  auto collect = [&](const LogRecord &record) { records.push_back(record); };
+  for (auto &r : current) {
+    r->drain(collect);
+    dropped += r->take_dropped();
+  }
+  current.clear();
+
+  {
+    // the threads of rings only referenced by this list exited; drain them once more before removing them
+    std::lock_guard<std::mutex> lock(mutex);
+    std::erase_if(rings, [&](const std::shared_ptr<LogRing> &r) {
+      if (r.use_count() > 1) return false;
+      r->drain(collect);
+      dropped += r->take_dropped();
+      return true;
+    });
+  }
+
+  if (records.empty() && dropped == 0) return;
+
+  // the messages of one thread are already in order, so a stable sort keeps split messages together
+  std::stable_sort(records.begin(), records.end(), [](const LogRecord &a, const LogRecord &b) { return a.tsc < b.tsc; });
+  std::string line;
+  for (const auto &record : records) {
+    write_record(record, line);
+  }
+  if (dropped) {
+    logfile << FC_RED "[-] " << dropped << " log records were dropped because the log ring was full." F_RESET "\n";
+  }
+  logfile.flush();
+}
+
+void Logger::write_record(const LogRecord &record, std::string &line) {
+  line.clear();
+  if (record.flags & LogRecord::FIRST) {
+    switch (record.level) {
+      case LogLevel::INFO: line += FC_CYAN "[+] "; break;
+      case LogLevel::HIGHLIGHT: line += FC_MAGENTA FF_BOLD "[+] "; break;
+      case LogLevel::ERROR: line += FC_RED "[-] "; break;
+      case LogLevel::DEBUG: line += FC_YELLOW "[DEBUG] "; break;
+      case LogLevel::SUCCESS: line += FC_GREEN "[!] "; break;
+      case LogLevel::FAILURE: line += FC_RED_BRIGHT "[-] "; break;
+      default: break;
+    }
+  }
+
+  if (record.level == LogLevel::BITFLIP) {
+    BitflipFields flip;
+    std::memcpy(&flip, record.payload, sizeof(flip));
+    std::stringstream ss;
+    ss << FC_GREEN
+       << "[!] Flip " << std::hex << (void *) flip.flipped_address << ", "
+       << std::dec << "bank " << flip.bank_no << ", "
+       << std::dec << "row " << flip.row_no << ", "
+       << "page offset: " << (uint64_t)flip.flipped_address%(uint64_t)getpagesize() << ", "
+       << "byte offset: " << (uint64_t)flip.flipped_address%(uint64_t)8 << ", "
+       << std::hex << "from " << (int) flip.expected_value << " to " << (int) flip.actual_value << ", "
+       << std::dec << "detected after " << format_timestamp(flip.timestamp - timestamp_start) << ".";
+    line += ss.str();
+  } else if (record.render != nullptr) {
+    record.render(record, line);
+  } else {
+    line.append(record.payload, record.length);
+  }
+
+  if (record.flags & LogRecord::LAST) {
+    if (record.level != LogLevel::DATA) line += F_RESET;
+    if (record.flags & LogRecord::NEWLINE) line += "\n";
+  }
+  logfile << line;
+}
+
 void Logger::log_info(const std::string &message, bool newline) {
-  mutex.lock();
-  instance.logfile << FC_CYAN "[+] " << message;
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  log_text(LogLevel::INFO, message, newline);
 }
 
 void Logger::log_highlight(const std::string &message, bool newline) {
-  mutex.lock();
-  instance.logfile << FC_MAGENTA << FF_BOLD << "[+] " << message;
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  log_text(LogLevel::HIGHLIGHT, message, newline);
 }
 
 void Logger::log_error(const std::string &message, bool newline) {
-  mutex.lock();
-  instance.logfile << FC_RED "[-] " << message;
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  log_text(LogLevel::ERROR, message, newline);
 }
 
 void Logger::log_data(const std::string &message, bool newline) {
-  mutex.lock();
-  instance.logfile << message;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  log_text(LogLevel::DATA, message, newline);
 }
 
 void Logger::log_analysis_stage(const std::string &message, bool newline) {
-  mutex.lock();
   std::stringstream ss;
   ss << FC_CYAN_BRIGHT "████  " << message << "  ";
   // this makes sure that all log analysis stage messages have the same length
   auto remaining_chars = 80-message.length();
   while (remaining_chars--) ss << "█";
-  instance.logfile << ss.str();
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  log_text(LogLevel::ANALYSIS_STAGE, ss.str(), newline);
 }
 
 void Logger::log_debug(const std::string &message, bool newline) {
 #ifdef DEBUG
-  instance.logfile << FC_YELLOW "[DEBUG] " << message;
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << std::endl;
+  log_text(LogLevel::DEBUG, message, newline);
 #else
   // this is just to ignore complaints of the compiler about unused params
   std::ignore = message;
@@ -102,34 +230,29 @@ void Logger::log_timestamp() {
 
 void Logger::log_bitflip(volatile char *flipped_address, uint64_t bank_no, uint64_t row_no, unsigned char actual_value,
                          unsigned char expected_value, unsigned long timestamp, bool newline) {
-  mutex.lock();
-  instance.logfile << FC_GREEN
-                   << "[!] Flip " << std::hex << (void *) flipped_address << ", "
-                   << std::dec << "bank " << bank_no << ", "
-                   << std::dec << "row " << row_no << ", "
-                   << "page offset: " << (uint64_t)flipped_address%(uint64_t)getpagesize() << ", "
-                   << "byte offset: " << (uint64_t)flipped_address%(uint64_t)8 << ", "
-                   << std::hex << "from " << (int) expected_value << " to " << (int) actual_value << ", "
-                   << std::dec << "detected after " << format_timestamp(timestamp - instance.timestamp_start) << ".";
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  auto &r = ring();
+  auto *record = r.reserve(0, 1);
+  if (record == nullptr) {
+    r.drop();
+    return;
+  }
+  BitflipFields flip { flipped_address, bank_no, row_no, timestamp, actual_value, expected_value };
+  record->tsc = __builtin_ia32_rdtsc();
+  record->render = nullptr;
+  record->format = nullptr;
+  record->level = LogLevel::BITFLIP;
+  record->flags = LogRecord::FIRST | LogRecord::LAST | (newline ? LogRecord::NEWLINE : 0);
+  record->length = sizeof(flip);
+  std::memcpy(record->payload, &flip, sizeof(flip));
+  r.commit(1);
 }
 
 void Logger::log_success(const std::string &message, bool newline) {
-  mutex.lock();
-  instance.logfile << FC_GREEN << "[!] " << message;
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  log_text(LogLevel::SUCCESS, message, newline);
 }
 
 void Logger::log_failure(const std::string &message, bool newline) {
-  mutex.lock();
-  instance.logfile << FC_RED_BRIGHT << "[-] " << message;
-  instance.logfile << F_RESET;
-  if (newline) instance.logfile << "\n";
-  mutex.unlock();
+  log_text(LogLevel::FAILURE, message, newline);
 }
 
 void Logger::log_metadata(const char *commit_hash, unsigned long run_time_limit_seconds) {
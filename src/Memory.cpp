@@ -1,15 +1,26 @@
 #include "Memory.hpp"
+#include "CpuTopology.hpp"
 #include "PatternAddressMapper.hpp"
+#include "PageChecksum.hpp"
+#include "PagemapCache.hpp"
+#include "StreamStore.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <fcntl.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
 #include <string>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
 #include <unistd.h>
-#define PAGEMAP_LENGTH 8
 
 const std::string F_NAME = "map_ident.bin";
 
@@ -19,63 +30,71 @@ uint64_t Memory::get_pfn(uint64_t entry) {
 }
 
 //----------------------------------------------------------
-uint64_t Memory::get_physical_address(uint64_t vaddr) 
-{
-  /* Credits to Balakumaran Kannan.
-   * URL: https://eastrivervillage.com/Virtual-memory-to-Physical-memory/
-   */
-    size_t pid;
-    size_t paddr = 0;
-    size_t offset;
-
-    int page_size;
-    int page_shift = -1;
-
-    char filename[1024] = {0};
-
-    page_size = getpagesize();
+uint64_t Memory::get_physical_address(uint64_t vaddr) {
+  return PagemapCache::get().translate(vaddr);
+}
 
-    pid = getpid();
-    sprintf(filename, "/proc/%ld/pagemap", pid);
+void Memory::get_physical_addresses(const std::vector<uint64_t> &vaddrs, std::vector<uint64_t> &paddrs) {
+  PagemapCache::get().translate(vaddrs, paddrs);
+}
 
-    FILE *pagemap = fopen(filename, "rb");
-    if (!pagemap) {
-      perror("can't open file. ");
-      goto err;
+size_t Memory::get_anon_huge_bytes() const {
+  // find the mapping that contains our allocation in smaps and read the amount of memory backed by transparent huge pages
+  FILE *smaps = fopen("/proc/self/smaps", "r");
+  if (smaps == nullptr) {
+    return 0;
+  }
+  char line[256];
+  bool in_mapping = false;
+  size_t huge_kb = 0;
+  while (fgets(line, sizeof(line), smaps) != nullptr) {
+    uint64_t from, to;
+    if (sscanf(line, "%lx-%lx ", &from, &to) == 2) {
+      in_mapping = (from <= (uint64_t) start_address && (uint64_t) start_address < to)
+          || ((uint64_t) start_address <= from && from < (uint64_t) start_address + size);
+      continue;
     }
+    size_t kb;
+    if (in_mapping && sscanf(line, "AnonHugePages: %zu kB", &kb) == 1) {
+      huge_kb += kb;
+    }
+  }
+  fclose(smaps);
+  return huge_kb*1024;
+}
 
-    offset = (vaddr / page_size) * PAGEMAP_LENGTH;
-    assert(fseek(pagemap, (long)offset, SEEK_SET) == 0);
-    assert(fread(&paddr, 1, (PAGEMAP_LENGTH-1), pagemap) == (PAGEMAP_LENGTH-1));
-
-    paddr = paddr & 0x7fffffffffffff;
-    offset = vaddr % page_size;
-
-    /* PAGE_SIZE = 1U << PAGE_SHIFT */
-    while (!((1UL << ++page_shift) & page_size));
-
-    paddr = (size_t)((size_t)paddr << page_shift) + offset;
-    
-    err:
-    fclose(pagemap);
-
-    return paddr;
+void Memory::wait_for_huge_pages(size_t timeout_ms) {
+  auto begin = std::chrono::steady_clock::now();
+  size_t huge_bytes = 0;
+  for (;;) {
+    huge_bytes = get_anon_huge_bytes();
+    auto waited_ms = (size_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    if (huge_bytes >= size || waited_ms >= timeout_ms) {
+      Logger::log_info(format_string("%zu of %zu MB are backed by huge pages after %zu ms.",
+                                     huge_bytes/MB(1), (size_t) (size/MB(1)), waited_ms));
+      return;
+    }
+    usleep(THP_POLL_INTERVAL_US);
+  }
 }
 
-/// Allocates a MEM_SIZE bytes of memory by using super or huge pages.
-void Memory::allocate_memory(size_t mem_size) {
-  this->size = mem_size;
+/// Allocates NUM_MAPPINGS times MEM_SIZE bytes of memory by using super or huge pages.
+void Memory::allocate_memory(size_t mem_size, size_t num_mappings) {
+  this->mapping_size = mem_size;
+  this->num_mappings = std::max<size_t>(num_mappings, 1);
   volatile char *target = nullptr;
 
   if (superpage) {
     // When allocating superpages, we need the allocation size to be a multiple of the superpage size.
-    Logger::log_data(format_string("Allocating %zu MB of memory...", size / MB(1)));
-    if (size % GB(1) != 0) {
+    Logger::log_data(format_string("Allocating %zu x %zu MB of memory...", this->num_mappings, mapping_size / MB(1)));
+    if (mapping_size % GB(1) != 0) {
       // Round up to the next GB.
-      auto num_gbs = size / GB(1) + 1;
-      size = GB(num_gbs);
-      Logger::log_data(format_string("Rounding up allocation to %zu MB", size / MB(1)));
+      auto num_gbs = mapping_size / GB(1) + 1;
+      mapping_size = GB(num_gbs);
+      Logger::log_data(format_string("Rounding up allocation to %zu MB", mapping_size / MB(1)));
     }
+    size = mapping_size*this->num_mappings;
     auto mapped_target = mmap(nullptr, size, PROT_READ | PROT_WRITE,
         MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB | (30UL << MAP_HUGE_SHIFT), -1, 0);
     if (mapped_target==MAP_FAILED) {
@@ -84,19 +103,29 @@ void Memory::allocate_memory(size_t mem_size) {
     }
     start_address = (volatile char*)mapped_target;
   } else {
-    // allocate memory using huge pages
-    assert(posix_memalign((void **) &target, size, size)==0);
+    // allocate memory using huge pages; every mapping must be aligned to its size so that the DRAM address matrices
+    // cover exactly one mapping
+    size = mapping_size*this->num_mappings;
+    assert(posix_memalign((void **) &target, mapping_size, size)==0);
     assert(madvise((void *) target, size, MADV_HUGEPAGE)==0);
-    memset((char *) target, 'A', size);
-    // for khugepaged
-    Logger::log_info("Waiting for khugepaged.");
-    sleep(10);
+    start_address = target;
   }
 
+  bind_mappings_to_nodes();
+
   // initialize memory with random but reproducible sequence of numbers
   // this needs to happen BEFORE calculating the physical address. Else, the OS would not map the page and the PFN will be 0.
   initialize(DATA_PATTERN::RANDOM);
 
+  // each huge page only needs to be translated once, all other addresses in it are derived from its base address
+  PagemapCache::get().add_region((uint64_t) start_address, size, superpage ? GB(1) : MB(2));
+
+  if (!superpage) {
+    // the initialization faulted in all pages; wait until khugepaged backed (nearly) all of them by huge pages
+    Logger::log_info("Waiting for khugepaged.");
+    wait_for_huge_pages(THP_WAIT_TIMEOUT_MS);
+  }
+
   uint64_t phys_addr = get_physical_address((uint64_t)start_address);
   if(access(F_NAME.c_str(), F_OK) != 0) {
     FILE *f = fopen(F_NAME.c_str(), "wb");
@@ -124,39 +153,105 @@ void Memory::allocate_memory(size_t mem_size) {
   }
 }
 
+void Memory::bind_mappings_to_nodes() {
+  auto nodes = CpuTopology::get().get_nodes();
+  if (num_mappings < 2 || nodes.size() < 2) {
+    return;
+  }
+  for (size_t i = 0; i < num_mappings; i++) {
+    auto node = nodes[i % nodes.size()];
+    unsigned long node_mask = 1UL << node;
+    // MPOL_PREFERRED instead of MPOL_BIND so that the allocation still succeeds if a node has no (huge) pages left
+    if (syscall(SYS_mbind, (void *) get_mapping_address(i), mapping_size, MPOL_PREFERRED, &node_mask,
+                sizeof(node_mask)*8, 0) != 0) {
+      Logger::log_error(format_string("Could not bind mapping %zu to NUMA node %d.", i, node));
+      continue;
+    }
+    Logger::log_info(format_string("Mapping %zu (%p) is preferably allocated on NUMA node %d.", i,
+                                   (void *) get_mapping_address(i), node));
+  }
+}
+
 void Memory::set_seed(uint64_t seed) {
   Memory::seed = seed;
+  rng.set_seed(seed);
 }
 
-void Memory::initialize(DATA_PATTERN data_pattern) {
-  Logger::log_info("Initializing memory with pseudorandom sequence.");
-  if(seed > 0) {
-    srand(seed);
+void Memory::fill_expected(uint32_t *page, uint64_t offset, size_t nwords) const {
+  if (data_pattern == DATA_PATTERN::RANDOM) {
+    rng.fill(page, offset, nwords);
+  } else {
+    std::fill_n(page, nwords, data_pattern == DATA_PATTERN::ONES ? 1U : 0U);
   }
+}
 
-  // for each page in the address space [start, end]
-  for (uint64_t cur_page = 0; cur_page < size; cur_page += getpagesize()) {
-    // reseed rand to have a sequence of reproducible numbers, using this we can compare the initialized values with
-    // those after hammering to see whether bit flips occurred
-    srand(static_cast<unsigned int>(cur_page*getpagesize()));
-    for (uint64_t cur_pageoffset = 0; cur_pageoffset < (uint64_t) getpagesize(); cur_pageoffset += sizeof(int)) {
-
-      int fill_value = 0;
-      if (data_pattern == DATA_PATTERN::RANDOM) {
-        fill_value = rand();
-      } else if (data_pattern == DATA_PATTERN::ZEROES) {
-        fill_value = 0;
-      } else if (data_pattern == DATA_PATTERN::ONES) {
-        fill_value = 1;
-      } else {
-        Logger::log_error("Could not initialize memory with given (unknown) DATA_PATTERN.");
+void Memory::initialize(DATA_PATTERN data_pattern) {
+  if (data_pattern != DATA_PATTERN::RANDOM && data_pattern != DATA_PATTERN::ZEROES && data_pattern != DATA_PATTERN::ONES) {
+    Logger::log_error("Could not initialize memory with given (unknown) DATA_PATTERN.");
+    return;
+  }
+  if (data_pattern == DATA_PATTERN::RANDOM) {
+    Logger::log_info(format_string("Initializing memory with pseudorandom sequence (%s kernel).", CounterRng::kernel_name()));
+  } else {
+    Logger::log_info(format_string("Initializing memory with %s.", data_pattern == DATA_PATTERN::ONES ? "ones" : "zeroes"));
+  }
+  this->data_pattern = data_pattern;
+
+  const auto pagesize = static_cast<uint64_t>(getpagesize());
+  page_checksums.resize(size/pagesize);
+
+  const uint64_t shard_size = std::max(pagesize, (uint64_t) SWEEP_SHARD_SIZE/pagesize*pagesize);
+  const size_t num_shards = (size + shard_size - 1)/shard_size;
+  const size_t num_cpus = std::max(1U, std::thread::hardware_concurrency());
+  const size_t num_threads = std::min(num_cpus, std::max((size_t) 1, num_shards));
+  std::atomic<size_t> next_shard(0);
+
+  auto worker = [&]() {
+    // the values are generated into a (cached) scratch page, checksummed there and then written to the allocation using
+    // streaming stores, this way we neither pollute the caches nor need to read the memory back for the checksum
+    auto *page = (uint32_t *) aligned_alloc(CACHELINE_SIZE, pagesize);
+    if (page == nullptr) {
+      Logger::log_error("Could not create temporary page for memory initialization.");
+      exit(EXIT_FAILURE);
+    }
+    size_t shard;
+    while ((shard = next_shard.fetch_add(1)) < num_shards) {
+      uint64_t shard_end = std::min(size, (shard + 1)*shard_size);
+      for (uint64_t cur_page = shard*shard_size; cur_page < shard_end; cur_page += pagesize) {
+        // the values only depend on (seed, offset), using this we can compare the initialized values with those after
+        // hammering to see whether bit flips occurred
+        fill_expected(page, cur_page, pagesize/sizeof(uint32_t));
+        page_checksums[cur_page/pagesize] = PageChecksum::compute(page, pagesize);
+        StreamStore::copy(start_address + cur_page, page, pagesize);
       }
-        
-      // write (pseudo)random 4 bytes
-      uint64_t offset = cur_page + cur_pageoffset;
-      *((int *) (start_address + offset)) = fill_value;
+    }
+    // make the weakly-ordered streaming stores globally visible before the memory is checked
+    sfence();
+    free(page);
+  };
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_threads; i++) {
+    workers.emplace_back(worker);
+    // pin each worker to its own core so that the threads do not compete for the same core
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(i % num_cpus, &cpuset);
+    if (pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpu_set_t), &cpuset) != 0) {
+      Logger::log_error(format_string("Could not pin initialization thread to CPU %zu.", i % num_cpus));
     }
   }
+  for (auto &t : workers) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+  auto bandwidth = (double) size/(double) GB(1)/elapsed.count();
+  printf("initialized %zu MB with %zu threads in %.3f s (%.2f GB/s).\n",
+         (size_t) (size/MB(1)), num_threads, elapsed.count(), bandwidth);
+  Logger::log_info(format_string("Initialized %zu bytes with %zu threads at %.2f GB/s.",
+                                 (size_t) size, num_threads, bandwidth));
 }
 
 size_t Memory::check_memory(PatternAddressMapper &mapping, bool reproducibility_mode, bool verbose) {
@@ -167,136 +262,233 @@ size_t Memory::check_memory(PatternAddressMapper &mapping, bool reproducibility_
   if (verbose) Logger::log_info(format_string("Checking %zu victims for bit flips.", victim_rows.size()));
 
   size_t sum_found_bitflips = 0;
+  std::vector<BitFlip> found;
   for (const auto &victim_row : victim_rows) {
-    auto start_addr = victim_row;
-    auto end_addr = victim_row + DRAMConfig::get().row_to_row_offset();
-    sum_found_bitflips += check_memory_internal(mapping, start_addr, end_addr, reproducibility_mode, verbose);
+    // only check the cache lines that actually belong to the victim row, these are scattered by the bank functions
+    RowFootprint footprint(DRAMAddr((void *) victim_row));
+    sum_found_bitflips += check_footprint(footprint, found, verbose);
   }
+  store_flips(mapping, found, reproducibility_mode);
   return sum_found_bitflips;
 }
 
 size_t Memory::check_memory(const volatile char *start, const volatile char *end) {
-  flipped_bits.clear();
-  // create a "fake" pattern mapping to keep this method for backward compatibility
-  PatternAddressMapper pattern_mapping(ColumnRandomizationStyle::NONE);
-  pattern_mapping.bit_flips.emplace_back();
-  return check_memory_internal(pattern_mapping, start, end, false, true);
+  // whole-range checks are split across all available cores
+  return sweep_memory(start, end, 0);
 }
 
-size_t Memory::check_memory_internal(PatternAddressMapper &mapping,
-                                     const volatile char *start,
-                                     const volatile char *end,
-                                     bool reproducibility_mode,
-                                     bool verbose) {
-  // counter for the number of found bit flips in the memory region [start, end]
-  size_t found_bitflips = 0;
-
+bool Memory::get_page_range(const volatile char *start, const volatile char *end,
+                            uint64_t &start_offset, uint64_t &end_offset) const {
   if (start==nullptr || end==nullptr || ((uint64_t) start >= (uint64_t) end)) {
     Logger::log_error("Function check_memory called with invalid arguments.");
     Logger::log_data(format_string("Start addr.: %s", DRAMAddr((void *) start).to_string().c_str()));
     Logger::log_data(format_string("End addr.: %s", DRAMAddr((void *) end).to_string().c_str()));
-    return found_bitflips;
+    return false;
   }
 
-  auto start_offset = (uint64_t) (start - start_address);
-
   const auto pagesize = static_cast<size_t>(getpagesize());
+  start_offset = (uint64_t) (start - start_address);
   start_offset = (start_offset/pagesize)*pagesize;
 
-  auto end_offset = start_offset + (uint64_t) (end - start);
+  end_offset = start_offset + (uint64_t) (end - start);
   end_offset = (end_offset/pagesize)*pagesize;
+  return true;
+}
+
+size_t Memory::sweep_memory(const volatile char *start, const volatile char *end, size_t num_threads) {
+  flipped_bits.clear();
+
+  uint64_t start_offset;
+  uint64_t end_offset;
+  if (!get_page_range(start, end, start_offset, end_offset)) {
+    return 0;
+  }
+
+  if (num_threads == 0) {
+    num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  // split the range into page-aligned shards that are handed out to the workers on demand; each shard has its own
+  // result buffer so that merging them in shard order is deterministic regardless of which worker checked it
+  const auto pagesize = static_cast<uint64_t>(getpagesize());
+  const uint64_t shard_size = std::max(pagesize, (uint64_t) SWEEP_SHARD_SIZE/pagesize*pagesize);
+  const size_t num_shards = (end_offset - start_offset + shard_size - 1)/shard_size;
+  num_threads = std::min(num_threads, std::max((size_t) 1, num_shards));
+
+  std::vector<std::vector<BitFlip>> shard_flips(num_shards);
+  std::vector<size_t> worker_found(num_threads, 0);
+  std::atomic<size_t> next_shard(0);
+
+  auto worker = [&](size_t worker_id) {
+    std::vector<uint32_t> page(pagesize/sizeof(uint32_t));
+    size_t shard;
+    while ((shard = next_shard.fetch_add(1)) < num_shards) {
+      uint64_t shard_start = start_offset + shard*shard_size;
+      uint64_t shard_end = std::min(end_offset, shard_start + shard_size);
+      for (uint64_t offset = shard_start; offset < shard_end; offset += pagesize) {
+        worker_found[worker_id] += check_page(offset, page.data(), shard_flips[shard], true);
+      }
+    }
+  };
+
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_threads; i++) {
+    workers.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto &t : workers) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+  size_t found_bitflips = 0;
+  for (auto found : worker_found) {
+    found_bitflips += found;
+  }
+  for (auto &flips : shard_flips) {
+    flipped_bits.insert(flipped_bits.end(), flips.begin(), flips.end());
+  }
+
+  auto scanned = (double) (end_offset - start_offset);
+  printf("swept %.2f GB with %zu threads in %.3f s (%.2f GB/s), found %zu flipped bits.\n",
+         scanned/(double) GB(1), num_threads, elapsed.count(), scanned/(double) GB(1)/elapsed.count(), found_bitflips);
+  Logger::log_info(format_string("Swept %zu bytes with %zu threads at %.2f GB/s.",
+                                 (size_t) scanned, num_threads, scanned/(double) GB(1)/elapsed.count()));
+  return found_bitflips;
+}
+
+void Memory::store_flips(PatternAddressMapper &mapping, const std::vector<BitFlip> &flips,
+                         bool reproducibility_mode) {
+  // store detailed information about the bit flips in the campaign's flip store, the mapping that triggered these bit
+  // flips only references them by their range in the store
+  if (!reproducibility_mode) {
+    if (mapping.bit_flips.empty()) {
+      Logger::log_error("Cannot store bit flips found in given address mapping.\n"
+                        "You need to create an empty range in PatternAddressMapper::bit_flips before calling "
+                        "check_memory.");
+    } else {
+      mapping.bit_flips.back() = FlipStore::get().add(flips);
+    }
+  }
+  // ..in an attribute of this class so that it can be retrived by the caller
+  flipped_bits.insert(flipped_bits.end(), flips.begin(), flips.end());
+}
+
+size_t Memory::check_footprint(const RowFootprint &footprint, std::vector<BitFlip> &flips, bool verbose) {
+  constexpr size_t words_per_line = CACHELINE_SIZE/sizeof(uint32_t);
+  uint32_t expected[words_per_line];
+  size_t found_bitflips = 0;
 
-  void *page_raw = malloc(pagesize);
-  if (page_raw == nullptr) {
-    Logger::log_error("Could not create temporary page for memory comparison.");
-    exit(EXIT_FAILURE);
+  for (auto line : footprint) {
+    // lines of rows that are only partially covered by the allocation must not be accessed
+    if ((uint64_t) line < (uint64_t) start_address || (uint64_t) line + CACHELINE_SIZE > (uint64_t) start_address + size)
+      continue;
+
+    uint64_t offset = (uint64_t) (line - start_address);
+    if (line_matches(offset))
+      continue;
+
+    fill_expected(expected, offset, words_per_line);
+    found_bitflips += diff_words(offset, expected, words_per_line, flips, verbose);
+  }
+  return found_bitflips;
+}
+
+bool Memory::line_matches(uint64_t line_offset) const {
+  constexpr size_t words_per_line = CACHELINE_SIZE/sizeof(uint32_t);
+  if (data_pattern == DATA_PATTERN::RANDOM) {
+    // compares against the generator output in registers, without writing the expected values to memory first
+    return rng.matches(start_address + line_offset, line_offset, words_per_line);
   }
-  memset(page_raw, 0, pagesize);
-  int *page = (int*)page_raw;
+  uint32_t expected[words_per_line];
+  fill_expected(expected, line_offset, words_per_line);
+  return memcmp((void*)(start_address + line_offset), expected, CACHELINE_SIZE) == 0;
+}
+
+size_t Memory::check_page(uint64_t page_offset, uint32_t *expected, std::vector<BitFlip> &flips, bool verbose) {
+  const auto pagesize = static_cast<uint64_t>(getpagesize());
+  uint64_t addr = ((uint64_t)start_address+page_offset);
+  size_t found_bitflips = 0;
+  bool page_in_bounds = (addr+pagesize) <= ((uint64_t)start_address+size);
+
+  // the common case is that nothing flipped: re-checksumming the page avoids regenerating its expected contents
+  uint64_t page_idx = page_offset/pagesize;
+  if (page_in_bounds && page_idx < page_checksums.size()
+      && PageChecksum::compute((void*)addr, pagesize) == page_checksums[page_idx])
+    return found_bitflips;
+
+  // fill comparison page with the expected values for this offset
+  fill_expected(expected, page_offset, pagesize/sizeof(uint32_t));
+
+  // check if any bit flipped in the page using the fast memcmp function, if any flip occurred we need to iterate over
+  // each byte one-by-one (much slower), otherwise we just continue with the next page
+  if (page_in_bounds && memcmp((void*)addr, (void*)expected, pagesize) == 0)
+    return found_bitflips;
+
+  return diff_words(page_offset, expected, pagesize/sizeof(uint32_t), flips, verbose);
+}
 
-  // for each page (4K) in the address space [start, end]
-  for (uint64_t i = start_offset; i < end_offset; i += pagesize) {
-    // reseed rand to have the desired sequence of reproducible numbers
-    srand(static_cast<unsigned int>(i*pagesize));
+size_t Memory::diff_words(uint64_t offset, const uint32_t *expected, size_t nwords, std::vector<BitFlip> &flips,
+                          bool verbose) {
+  size_t found_bitflips = 0;
+
+  // iterate over blocks of 4 bytes (=sizeof(int))
+  for (uint64_t j = 0; j < nwords*sizeof(int); j += sizeof(int)) {
+    uint64_t word_offset = offset + j;
+    volatile char *cur_addr = start_address + word_offset;
 
-    // fill comparison page with expected values generated by rand()
-    for (size_t j = 0; j < (unsigned long) pagesize/sizeof(int); ++j)
-      page[j] = rand();
+    // if this address is outside the superpage we must not proceed to avoid segfault
+    if ((uint64_t)cur_addr >= ((uint64_t)start_address+size))
+      continue;
 
-    uint64_t addr = ((uint64_t)start_address+i);
+    // clear the cache to make sure we do not access a cached value
+    clflushopt(cur_addr);
+    mfence();
 
-    // check if any bit flipped in the page using the fast memcmp function, if any flip occurred we need to iterate over
-    // each byte one-by-one (much slower), otherwise we just continue with the next page
-    if ((addr+ pagesize) < ((uint64_t)start_address+size) && memcmp((void*)addr, (void*)page, pagesize) == 0)
+    // if the bit did not flip -> continue checking next block
+    int expected_rand_value = (int) expected[j/sizeof(int)];
+    if (*((int *) cur_addr)==expected_rand_value)
       continue;
 
-    // iterate over blocks of 4 bytes (=sizeof(int))
-    for (uint64_t j = 0; j < (uint64_t) pagesize; j += sizeof(int)) {
-      uint64_t offset = i + j;
-      volatile char *cur_addr = start_address + offset;
-
-      // if this address is outside the superpage we must not proceed to avoid segfault
-      if ((uint64_t)cur_addr >= ((uint64_t)start_address+size))
-        continue;
-
-      // clear the cache to make sure we do not access a cached value
-      clflushopt(cur_addr);
-      mfence();
-
-      // if the bit did not flip -> continue checking next block
-      int expected_rand_value = page[j/sizeof(int)];
-      if (*((int *) cur_addr)==expected_rand_value)
-        continue;
-
-      // if the bit flipped -> compare byte per byte
-      for (unsigned long c = 0; c < sizeof(int); c++) {
-        volatile char *flipped_address = cur_addr + c;
-        if (*flipped_address != ((char *) &expected_rand_value)[c]) {
-          const auto flipped_addr_dram = DRAMAddr((void *) flipped_address);
-          assert(flipped_address == (volatile char*)flipped_addr_dram.to_virt());
-          const auto flipped_addr_value = *(unsigned char *) flipped_address;
-          const auto expected_value = ((unsigned char *) &expected_rand_value)[c];
-          if (verbose) {
-            Logger::log_bitflip(flipped_address, flipped_addr_dram.actual_bank(), flipped_addr_dram.row,
-                expected_value, flipped_addr_value, (size_t) time(nullptr), true);
-          }
-          // store detailed information about the bit flip
-          BitFlip bitflip(flipped_addr_dram, (expected_value ^ flipped_addr_value), flipped_addr_value);
-          // ..in the mapping that triggered this bit flip
-          if (!reproducibility_mode) {
-            if (mapping.bit_flips.empty()) {
-              Logger::log_error("Cannot store bit flips found in given address mapping.\n"
-                                "You need to create an empty vector in PatternAddressMapper::bit_flips before calling "
-                                "check_memory.");
-            }
-            mapping.bit_flips.back().push_back(bitflip);
-          }
-          // ..in an attribute of this class so that it can be retrived by the caller
-          flipped_bits.push_back(bitflip);
-          found_bitflips += bitflip.count_bit_corruptions();
+    // if the bit flipped -> compare byte per byte
+    for (unsigned long c = 0; c < sizeof(int); c++) {
+      volatile char *flipped_address = cur_addr + c;
+      if (*flipped_address != ((char *) &expected_rand_value)[c]) {
+        const auto flipped_addr_dram = DRAMAddr((void *) flipped_address);
+        assert(flipped_address == (volatile char*)flipped_addr_dram.to_virt());
+        const auto flipped_addr_value = *(unsigned char *) flipped_address;
+        const auto expected_value = ((unsigned char *) &expected_rand_value)[c];
+        if (verbose) {
+          Logger::log_bitflip(flipped_address, flipped_addr_dram.actual_bank(), flipped_addr_dram.row,
+              expected_value, flipped_addr_value, (size_t) time(nullptr), true);
         }
+        // store detailed information about the bit flip
+        BitFlip bitflip(flipped_addr_dram, (expected_value ^ flipped_addr_value), flipped_addr_value);
+        flips.push_back(bitflip);
+        found_bitflips += bitflip.count_bit_corruptions();
       }
+    }
 
-      // restore original (unflipped) value
-      *((int *) cur_addr) = expected_rand_value;
+    // restore original (unflipped) value
+    *((int *) cur_addr) = expected_rand_value;
 
-      // flush this address so that value is committed before hammering again there
-      clflushopt(cur_addr);
-      mfence();
-    }
+    // flush this address so that value is committed before hammering again there
+    clflushopt(cur_addr);
+    mfence();
   }
-  
-  free(page);
+
   return found_bitflips;
 }
 
-Memory::Memory(bool use_superpage) : size(0), superpage(use_superpage), seed(0) {
+Memory::Memory(bool use_superpage) : size(0), superpage(use_superpage), seed(0), rng(0) {
 }
 
-Memory::Memory(bool use_superpage, uint64_t seed) : size(0), superpage(use_superpage), seed(seed) {
+Memory::Memory(bool use_superpage, uint64_t seed) : size(0), superpage(use_superpage), seed(seed), rng(seed) {
 }
 
 Memory::~Memory() {
+  PagemapCache::get().remove_region((uint64_t) start_address);
   if (munmap((void *) start_address, size) == -1) {
     Logger::log_error("munmap failed with error:");
     Logger::log_data(strerror(errno));
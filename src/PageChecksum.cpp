@@ -0,0 +1,27 @@
+#include "PageChecksum.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <nmmintrin.h>
+
+uint32_t PageChecksum::compute(const void *data, size_t len) {
+  const auto *words = (const uint64_t *) data;
+  const size_t nwords = len/sizeof(uint64_t);
+
+  uint64_t crc0 = 0xffffffffU;
+  uint64_t crc1 = 0xffffffffU;
+  uint64_t crc2 = 0xffffffffU;
+  uint64_t crc3 = 0xffffffffU;
+  for (size_t i = 0; i + 4 <= nwords; i += 4) {
+    crc0 = _mm_crc32_u64(crc0, words[i]);
+    crc1 = _mm_crc32_u64(crc1, words[i + 1]);
+    crc2 = _mm_crc32_u64(crc2, words[i + 2]);
+    crc3 = _mm_crc32_u64(crc3, words[i + 3]);
+  }
+
+  // crc32(h, x) is a bijection in x for a fixed h, hence a change in any single stream changes the result
+  auto crc = (uint32_t) crc0;
+  crc = _mm_crc32_u32(crc, (uint32_t) crc1);
+  crc = _mm_crc32_u32(crc, (uint32_t) crc2);
+  crc = _mm_crc32_u32(crc, (uint32_t) crc3);
+  return ~crc;
+}
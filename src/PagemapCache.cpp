@@ -0,0 +1,120 @@
+#include "PagemapCache.hpp"
+#include "Logger.hpp"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PAGEMAP_ENTRY_SIZE 8
+#define PAGEMAP_PFN_MASK 0x7fffffffffffffULL
+
+PagemapCache &PagemapCache::get() {
+  static PagemapCache instance;
+  return instance;
+}
+
+PagemapCache::~PagemapCache() {
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+void PagemapCache::add_region(uint64_t start, uint64_t size, uint64_t page_size) {
+  std::lock_guard<std::mutex> lock(mutex);
+  regions.push_back({start, size, page_size});
+}
+
+void PagemapCache::remove_region(uint64_t start) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = regions.begin(); it != regions.end(); it++) {
+    if (it->start != start) continue;
+    for (auto t = translations.begin(); t != translations.end();) {
+      if (t->first >= it->start && t->first < it->start + it->size) {
+        t = translations.erase(t);
+      } else {
+        t++;
+      }
+    }
+    for (auto f = fragmented_units.begin(); f != fragmented_units.end();) {
+      if (*f >= it->start && *f < it->start + it->size) {
+        f = fragmented_units.erase(f);
+      } else {
+        f++;
+      }
+    }
+    regions.erase(it);
+    return;
+  }
+}
+
+uint64_t PagemapCache::read_pagemap(uint64_t vaddr) {
+  if (fd < 0) {
+    fd = open("/proc/self/pagemap", O_RDONLY);
+    if (fd < 0) {
+      perror("can't open file. ");
+      return 0;
+    }
+  }
+
+  const auto page_size = static_cast<uint64_t>(getpagesize());
+  uint64_t entry = 0;
+  auto offset = (off_t) ((vaddr/page_size)*PAGEMAP_ENTRY_SIZE);
+  if (pread(fd, &entry, PAGEMAP_ENTRY_SIZE, offset) != PAGEMAP_ENTRY_SIZE) {
+    Logger::log_error(format_string("Could not read pagemap entry for virtual address 0x%lx.", vaddr));
+    return 0;
+  }
+  return (entry & PAGEMAP_PFN_MASK)*page_size;
+}
+
+uint64_t PagemapCache::get_unit_size(uint64_t vaddr) const {
+  for (const auto &region : regions) {
+    if (vaddr >= region.start && vaddr < region.start + region.size) {
+      return region.page_size;
+    }
+  }
+  return static_cast<uint64_t>(getpagesize());
+}
+
+uint64_t PagemapCache::translate_locked(uint64_t vaddr) {
+  const auto page_size = static_cast<uint64_t>(getpagesize());
+  auto unit_size = get_unit_size(vaddr);
+  auto unit_base = vaddr & ~(unit_size - 1);
+  if (unit_size > page_size && fragmented_units.count(unit_base) > 0) {
+    unit_size = page_size;
+    unit_base = vaddr & ~(unit_size - 1);
+  }
+
+  auto it = translations.find(unit_base);
+  if (it == translations.end()) {
+    auto phys_base = read_pagemap(unit_base);
+    // PFNs are zeroed if we lack the privileges to read them; don't cache these to not hide the real translations
+    if (phys_base == 0) {
+      return 0;
+    }
+    if (unit_size > page_size && read_pagemap(unit_base + unit_size - page_size) != phys_base + unit_size - page_size) {
+      // the region is not physically contiguous (e.g., THP that were not collapsed), fall back to 4 KB pages
+      fragmented_units.insert(unit_base);
+      unit_size = page_size;
+      unit_base = vaddr & ~(unit_size - 1);
+      phys_base = read_pagemap(unit_base);
+      if (phys_base == 0) {
+        return 0;
+      }
+    }
+    it = translations.emplace(unit_base, phys_base).first;
+  }
+  return it->second + (vaddr - unit_base);
+}
+
+uint64_t PagemapCache::translate(uint64_t vaddr) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return translate_locked(vaddr);
+}
+
+void PagemapCache::translate(const std::vector<uint64_t> &vaddrs, std::vector<uint64_t> &paddrs) {
+  std::lock_guard<std::mutex> lock(mutex);
+  paddrs.resize(vaddrs.size());
+  for (size_t i = 0; i < vaddrs.size(); i++) {
+    paddrs[i] = translate_locked(vaddrs[i]);
+  }
+}
@@ -13,8 +13,9 @@
 
 // initialize the bank_counter (static var)
 int PatternAddressMapper::bank_counter = 0;
-std::mt19937 PatternAddressMapper::gen = std::mt19937(std::random_device()());
-std::mt19937 PatternAddressMapper::col_gen = std::mt19937(std::random_device()());
+int PatternAddressMapper::mapping_counter = 0;
+thread_local std::mt19937 PatternAddressMapper::gen = std::mt19937(std::random_device()());
+thread_local std::mt19937 PatternAddressMapper::col_gen = std::mt19937(std::random_device()());
 
 PatternAddressMapper::PatternAddressMapper(ColumnRandomizationStyle randomization_style)
     : instance_id(uuid::gen_uuid()), randomization_style(randomization_style) { /* NOLINT */
@@ -37,8 +38,14 @@ void PatternAddressMapper::randomize_addresses(FuzzingParameterSet &fuzzing_para
   // retrieve and then store randomized values as they should be the same for all added addresses
   // (store bank_no as field for get_random_nonaccessed_rows)
   bank_no = PatternAddressMapper::bank_counter;
+  mapping_id = PatternAddressMapper::mapping_counter;
   PatternAddressMapper::bank_counter = static_cast<int>(
     (PatternAddressMapper::bank_counter + 1) % DRAMConfig::get().banks());
+  if (PatternAddressMapper::bank_counter == 0 && DRAMAddr::num_mappings() > 1) {
+    PatternAddressMapper::mapping_counter = static_cast<int>(
+      (PatternAddressMapper::mapping_counter + 1) % DRAMAddr::num_mappings());
+  }
+  const auto bank = DRAMAddr::translate_bank(0, mapping_id, bank_no);
   const bool use_seq_addresses = fuzzing_params.get_random_use_seq_addresses();
   const int start_row = fuzzing_params.get_random_start_row();
   if (verbose) FuzzingParameterSet::print_dynamic_parameters(bank_no, use_seq_addresses, start_row);
@@ -139,7 +146,7 @@ void PatternAddressMapper::randomize_addresses(FuzzingParameterSet &fuzzing_para
 
       size_t col = randomization_style == ColumnRandomizationStyle::PER_AGGRESSOR ? col_distribution(col_gen) : 0;
       
-      aggressor_to_addr.insert(std::make_pair(current_agg.id, DRAMAddr(static_cast<size_t>(bank_no), row, col)));
+      aggressor_to_addr.insert(std::make_pair(current_agg.id, DRAMAddr(bank, row, col, mapping_id)));
     }
   }
 
@@ -177,7 +184,7 @@ void PatternAddressMapper::determine_victims(const std::vector<AggressorAccessPa
           continue;
 
         // ignore this victim if we already added it before
-        auto victim_start = DRAMAddr(dram_addr.bank, static_cast<size_t>(cur_row_candidate), 0);
+        auto victim_start = DRAMAddr(dram_addr.bank, static_cast<size_t>(cur_row_candidate), 0, dram_addr.mapping_id);
         if (victim_rows.count(static_cast<volatile char *>(victim_start.to_virt())) > 0)
           continue;
         victim_rows.insert(static_cast<volatile char *>(victim_start.to_virt()));
@@ -186,20 +193,31 @@ void PatternAddressMapper::determine_victims(const std::vector<AggressorAccessPa
   }
 }
 
-std::vector<volatile char *> PatternAddressMapper::interleave(
-  std::vector<std::vector<volatile char *>> &patterns, 
+static bool is_fence(const PatternOp &op) {
+  return op.type == PatternOpType::FENCE;
+}
+
+static void append(PatternIR &pattern, const PatternOp &op) {
+  if(is_fence(op)) {
+    pattern.fence();
+  } else {
+    pattern.access(op.addr);
+  }
+}
+
+PatternIR PatternAddressMapper::interleave(
+  std::vector<PatternIR> &patterns, 
   size_t chunk_size, 
   size_t distance,
   size_t count_per_iter
 ) {
-  std::vector<volatile char *> final_pattern;
+  PatternIR final_pattern;
   
   if(patterns.size() == 1) {
     return patterns[0];
   }
 
   std::uniform_int_distribution<> random_pattern_dist(1, patterns.size() - 1);
-  std::vector<volatile char *> &main_pattern = patterns[0];
   
   std::vector<size_t> pattern_indices(patterns.size(), 0);
   
@@ -211,11 +229,11 @@ std::vector<volatile char *> PatternAddressMapper::interleave(
         break;
       }
       int aggressor_index = pattern_indices[0]++;
-      if(patterns[0][aggressor_index] == nullptr && final_pattern.size() > 0 && final_pattern.back() == nullptr && c == 0) {
+      if(is_fence(patterns[0][aggressor_index]) && final_pattern.size() > 0 && is_fence(final_pattern[final_pattern.size() - 1]) && c == 0) {
         c--;
         continue;
       }
-      final_pattern.push_back(patterns[0][aggressor_index]);
+      append(final_pattern, patterns[0][aggressor_index]);
     }
 
     if(count++ % distance != 0) {
@@ -229,11 +247,11 @@ std::vector<volatile char *> PatternAddressMapper::interleave(
           pattern_indices[pattern_index] = 0;
         }
         size_t aggressor_index = pattern_indices[pattern_index]++;
-        if(patterns[pattern_index][aggressor_index] == nullptr && final_pattern.back() == nullptr && cnt == 0) {
+        if(is_fence(patterns[pattern_index][aggressor_index]) && is_fence(final_pattern[final_pattern.size() - 1]) && cnt == 0) {
           cnt--;
           continue;
         }
-        final_pattern.push_back(patterns[pattern_index][aggressor_index]);
+        append(final_pattern, patterns[pattern_index][aggressor_index]);
       }
     }
   }
@@ -242,7 +260,11 @@ std::vector<volatile char *> PatternAddressMapper::interleave(
 
   int print_size = std::min(final_pattern.size() - 1, (size_t)40);
   for(int i = 0; i < print_size; i++) {
-    printf("%s, ", DRAMAddr((void *)final_pattern[i]).to_string_compact().c_str());
+    if(is_fence(final_pattern[i])) {
+      printf("FENCE, ");
+      continue;
+    }
+    printf("%s, ", DRAMAddr((void *)final_pattern[i].addr).to_string_compact().c_str());
   }
 
   return final_pattern;
@@ -483,7 +505,7 @@ static SCHEDULING_POLICY get_default_scheduling_policy_for_uarch() {
   }
 }
 
-std::vector<volatile char*> PatternAddressMapper::export_pattern(const HammeringPattern& pattern, SCHEDULING_POLICY scheduling_policy) {
+PatternIR PatternAddressMapper::export_pattern(const HammeringPattern& pattern, SCHEDULING_POLICY scheduling_policy) {
   if (scheduling_policy == SCHEDULING_POLICY::DEFAULT)
     scheduling_policy = get_default_scheduling_policy_for_uarch();
 
@@ -491,17 +513,17 @@ std::vector<volatile char*> PatternAddressMapper::export_pattern(const Hammering
 
   switch (scheduling_policy) {
     case SCHEDULING_POLICY::NONE:
-      return export_pattern_with_fence_none(pattern);
+      return PatternIR::from_aggressors(export_pattern_with_fence_none(pattern));
     case SCHEDULING_POLICY::FULL:
-      return export_pattern_with_fence_all(pattern);
+      return PatternIR::from_aggressors(export_pattern_with_fence_all(pattern));
     case SCHEDULING_POLICY::BASE_PERIOD:
-      return export_pattern_with_fence_per_base_period(pattern, 1);
+      return PatternIR::from_aggressors(export_pattern_with_fence_per_base_period(pattern, 1));
     case SCHEDULING_POLICY::HALF_BASE_PERIOD:
-      return export_pattern_with_fence_per_base_period(pattern, 2);
+      return PatternIR::from_aggressors(export_pattern_with_fence_per_base_period(pattern, 2));
     case SCHEDULING_POLICY::PAIR:
-      return export_pattern_with_fence_between_tuples(pattern);
+      return PatternIR::from_aggressors(export_pattern_with_fence_between_tuples(pattern));
     case SCHEDULING_POLICY::REPETITON:
-      return export_pattern_with_fence_between_tuple_iterations(pattern);
+      return PatternIR::from_aggressors(export_pattern_with_fence_between_tuple_iterations(pattern));
     default:
       assert(false && "Unreachable.");
   }
@@ -537,12 +559,18 @@ void to_json(nlohmann::json &j, const PatternAddressMapper &p) {
     return;
   }
 
+  std::vector<std::vector<BitFlip>> bit_flips;
+  for (const auto &range : p.bit_flips) {
+    bit_flips.push_back(FlipStore::get().get_flips(range));
+  }
+
   j = nlohmann::json{{"id", p.get_instance_id()},
                      {"aggressor_to_addr", p.aggressor_to_addr},
-                     {"bit_flips", p.bit_flips},
+                     {"bit_flips", bit_flips},
                      {"min_row", p.min_row},
                      {"max_row", p.max_row},
                      {"bank_no", p.bank_no},
+                     {"mapping_id", p.mapping_id},
                      {"reproducibility_score", p.reproducibility_score},
                      {"code_jitter", *p.code_jitter}
   };
@@ -551,10 +579,16 @@ void to_json(nlohmann::json &j, const PatternAddressMapper &p) {
 void from_json(const nlohmann::json &j, PatternAddressMapper &p) {
   j.at("id").get_to(p.get_instance_id());
   j.at("aggressor_to_addr").get_to(p.aggressor_to_addr);
-  j.at("bit_flips").get_to(p.bit_flips);
+  std::vector<std::vector<BitFlip>> bit_flips;
+  j.at("bit_flips").get_to(bit_flips);
+  p.bit_flips.clear();
+  for (const auto &flips : bit_flips) {
+    p.bit_flips.push_back(FlipStore::get().add(flips));
+  }
   j.at("min_row").get_to(p.min_row);
   j.at("max_row").get_to(p.max_row);
   j.at("bank_no").get_to(p.bank_no);
+  p.mapping_id = j.contains("mapping_id") ? j.at("mapping_id").get<int>() : 0;
   j.at("reproducibility_score").get_to(p.reproducibility_score);
   p.code_jitter = std::make_unique<CodeJitter>();
   j.at("code_jitter").get_to(*p.code_jitter);
@@ -577,10 +611,11 @@ const std::unordered_set<volatile char *> &PatternAddressMapper::get_victim_rows
 std::vector<volatile char *> PatternAddressMapper::get_random_nonaccessed_rows(int row_upper_bound) {
   // we don't mind if addresses are added multiple times
   std::vector<volatile char *> addresses;
+  const auto bank = DRAMAddr::translate_bank(0, mapping_id, bank_no);
   for (int i = 0; i < 1024; ++i) {
     auto row_no = Range<int>(max_row, max_row + min_row).get_random_number(gen)%row_upper_bound;
     addresses.push_back(
-        static_cast<volatile char*>(DRAMAddr(static_cast<size_t>(bank_no), static_cast<size_t>(row_no), 0).to_virt()));
+        static_cast<volatile char*>(DRAMAddr(bank, static_cast<size_t>(row_no), 0, mapping_id).to_virt()));
   }
   return addresses;
 }
@@ -615,6 +650,22 @@ void PatternAddressMapper::shift_mapping(int rows, const std::unordered_set<Aggr
   }
 }
 
+void PatternAddressMapper::move_to_mapping(int new_mapping_id) {
+  const auto bank = DRAMAddr::translate_bank(0, new_mapping_id, bank_no);
+  for (auto &[id, addr] : aggressor_to_addr) {
+    addr.bank = bank;
+    addr.mapping_id = new_mapping_id;
+  }
+
+  std::unordered_set<volatile char *> moved_victims;
+  for (auto *victim : victim_rows) {
+    DRAMAddr addr((void *) victim);
+    moved_victims.insert(static_cast<volatile char *>(DRAMAddr(bank, addr.row, addr.col, new_mapping_id).to_virt()));
+  }
+  victim_rows = std::move(moved_victims);
+  mapping_id = new_mapping_id;
+}
+
 CodeJitter &PatternAddressMapper::get_code_jitter() const {
   return *code_jitter;
 }
@@ -625,6 +676,7 @@ PatternAddressMapper::PatternAddressMapper(const PatternAddressMapper &other)
       min_row(other.min_row),
       max_row(other.max_row),
       bank_no(other.bank_no),
+      mapping_id(other.mapping_id),
       aggressor_to_addr(other.aggressor_to_addr),
       bit_flips(other.bit_flips),
       reproducibility_score(other.reproducibility_score),
@@ -655,6 +707,7 @@ PatternAddressMapper &PatternAddressMapper::operator=(const PatternAddressMapper
   min_row = other.min_row;
   max_row = other.max_row;
   bank_no = other.bank_no;
+  mapping_id = other.mapping_id;
 
   aggressor_to_addr = other.aggressor_to_addr;
   bit_flips = other.bit_flips;
@@ -703,7 +756,7 @@ void PatternAddressMapper::compute_mapping_stats(std::vector<AggressorAccessPatt
 
 size_t PatternAddressMapper::count_bitflips() const {
   size_t sum = 0;
-  for (const auto &bf : bit_flips) sum += bf.size();
+  for (const auto &bf : bit_flips) sum += bf.count;
   return sum;
 }
 
@@ -0,0 +1,163 @@
+#include "PatternIR.hpp"
+#include "DRAMAddr.hpp"
+#include "Logger.hpp"
+
+#include <unordered_map>
+
+PatternIR PatternIR::from_aggressors(const std::vector<volatile char *> &aggressors) {
+  PatternIR ir;
+  ir.ops.reserve(aggressors.size());
+  for (auto *aggr : aggressors) {
+    if (aggr == nullptr) {
+      ir.fence();
+    } else {
+      ir.access(aggr);
+    }
+  }
+  return ir;
+}
+
+size_t PatternIR::num_accesses() const {
+  size_t count = 0;
+  for (const auto &op : ops) {
+    if (op.type == PatternOpType::ACCESS) {
+      count++;
+    }
+  }
+  return count;
+}
+
+volatile char *PatternIR::first_access() const {
+  for (const auto &op : ops) {
+    if (op.type == PatternOpType::ACCESS) {
+      return op.addr;
+    }
+  }
+  return nullptr;
+}
+
+volatile char *PatternIR::last_access() const {
+  for (auto it = ops.rbegin(); it != ops.rend(); it++) {
+    if (it->type == PatternOpType::ACCESS) {
+      return it->addr;
+    }
+  }
+  return nullptr;
+}
+
+bool PatternIR::same_shape(const PatternIR &other) const {
+  if (ops.size() != other.ops.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < ops.size(); i++) {
+    if (ops[i].type != other.ops[i].type) {
+      return false;
+    }
+  }
+  return true;
+}
+
+PatternIR PatternIR::make_loop(FLUSHING_STRATEGY flushing, FENCING_STRATEGY fencing) const {
+  PatternIR loop = *this;
+  loop.schedule_flushes(flushing, fencing);
+  loop.eliminate_dead_flushes();
+  loop.coalesce_fences();
+
+  // the hammering loop only ends after a number of ACTs, hence a pattern without accesses would never terminate
+  auto *first_addr = first_access();
+  if (first_addr == nullptr) {
+    Logger::log_error("Cannot build a hammering loop from a pattern without accesses.");
+    exit(EXIT_FAILURE);
+  }
+  auto first = DRAMAddr((void *) first_addr);
+  loop.sync((volatile char *) DRAMAddr(first.bank, 0, 0, first.mapping_id).to_virt());
+  loop.loop_back();
+  return loop;
+}
+
+void PatternIR::schedule_flushes(FLUSHING_STRATEGY flushing, FENCING_STRATEGY fencing) {
+  PatternIR scheduled;
+  scheduled.ops.reserve(2*ops.size());
+
+  // keeps track of rows that have been accessed before and need a flush/fence before their next access
+  std::unordered_map<size_t, bool> accessed_before;
+
+  for (const auto &op : ops) {
+    if (op.type != PatternOpType::ACCESS) {
+      scheduled.ops.push_back(op);
+      continue;
+    }
+
+    auto row = DRAMAddr((void *) op.addr).actual_row();
+    if (accessed_before[row]) {
+      if (flushing == FLUSHING_STRATEGY::LATEST_POSSIBLE) {
+        scheduled.flush(op.addr);
+        accessed_before[row] = false;
+      }
+      // fence to ensure flushing finished and defined order of aggressors is guaranteed
+      if (fencing == FENCING_STRATEGY::LATEST_POSSIBLE) {
+        scheduled.fence();
+        accessed_before[row] = false;
+      }
+    }
+
+    scheduled.ops.push_back(op);
+    accessed_before[row] = true;
+
+    if (flushing == FLUSHING_STRATEGY::EARLIEST_POSSIBLE) {
+      scheduled.flush(op.addr);
+    }
+  }
+
+  // we have not flushed any aggressors during the pattern, so we need to do it now
+  if (flushing == FLUSHING_STRATEGY::OMIT_FLUSHING) {
+    for (const auto &op : ops) {
+      if (op.type == PatternOpType::ACCESS) {
+        scheduled.flush(op.addr);
+      }
+    }
+  }
+
+  // fences -> ensure that aggressors are not interleaved, i.e., we access aggressors always in same order
+  if (fencing != FENCING_STRATEGY::OMIT_FENCING) {
+    scheduled.fence();
+  }
+
+  ops = std::move(scheduled.ops);
+}
+
+void PatternIR::eliminate_dead_flushes() {
+  // the last op (ACCESS or FLUSH) on each address
+  std::unordered_map<volatile char *, PatternOpType> last_op;
+  std::vector<PatternOp> live;
+  live.reserve(ops.size());
+
+  for (const auto &op : ops) {
+    if (op.type == PatternOpType::ACCESS || op.type == PatternOpType::FLUSH) {
+      auto [it, inserted] = last_op.emplace(op.addr, op.type);
+      if (!inserted) {
+        if (op.type == PatternOpType::FLUSH && it->second == PatternOpType::FLUSH) {
+          continue;
+        }
+        it->second = op.type;
+      }
+    }
+    live.push_back(op);
+  }
+
+  ops = std::move(live);
+}
+
+void PatternIR::coalesce_fences() {
+  std::vector<PatternOp> coalesced;
+  coalesced.reserve(ops.size());
+
+  for (const auto &op : ops) {
+    if (op.type == PatternOpType::FENCE && !coalesced.empty() && coalesced.back().type == PatternOpType::FENCE) {
+      continue;
+    }
+    coalesced.push_back(op);
+  }
+
+  ops = std::move(coalesced);
+}
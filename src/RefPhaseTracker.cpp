@@ -0,0 +1,177 @@
+#include "RefPhaseTracker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <pthread.h>
+#include <sched.h>
+#include <vector>
+#include <x86intrin.h>
+
+// the window around a predicted edge in which the tracker probes is period / WINDOW_DIVISOR wide on each side, but at
+// least MIN_WINDOW cycles
+#define WINDOW_DIVISOR 8
+#define MIN_WINDOW 1000
+// the weight of a new edge distance in the period estimate is 1 / PERIOD_SMOOTHING
+#define PERIOD_SMOOTHING 16
+
+RefPhaseTracker &RefPhaseTracker::get() {
+  static RefPhaseTracker instance;
+  return instance;
+}
+
+RefPhaseTracker::~RefPhaseTracker() {
+  stop();
+}
+
+bool RefPhaseTracker::start(int cpu, volatile char *probe_addr, uint64_t threshold) {
+  stop();
+  this->cpu = cpu;
+  this->probe_addr = probe_addr;
+  this->threshold = threshold;
+  reset_stats();
+  stopping = false;
+  locked = false;
+  tracker = std::thread(&RefPhaseTracker::track, this);
+
+  //the tracker only observes edges if the threshold fits the probed row, so do not wait for it forever
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(START_TIMEOUT_MS);
+  while(!is_locked()) {
+    if(std::chrono::steady_clock::now() >= deadline) {
+      stop();
+      printf("[WARN] the REF tracker on cpu %d did not estimate the period within %lu ms.\n", cpu, START_TIMEOUT_MS);
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  printf("tracking REF on cpu %d: period of %lu cycles.\n", cpu, prediction.period.load());
+  return true;
+}
+
+void RefPhaseTracker::stop() {
+  if(!tracker.joinable()) {
+    return;
+  }
+  stopping = true;
+  tracker.join();
+  locked = false;
+}
+
+void RefPhaseTracker::reset_stats() {
+  edges = 0;
+  missed = 0;
+  sum_abs_error = 0;
+  max_abs_error = 0;
+  num_errors = 0;
+}
+
+double RefPhaseTracker::get_mean_sync_error() const {
+  return num_errors == 0 ? 0 : (double) sum_abs_error / num_errors;
+}
+
+uint64_t RefPhaseTracker::probe_until(uint64_t deadline) {
+  uint32_t tsc_aux;
+  const uint64_t threshold = this->threshold.load(std::memory_order_relaxed);
+  while(!stopping.load(std::memory_order_relaxed)) {
+    _mm_clflushopt((void *) probe_addr);
+    _mm_mfence();
+    _mm_lfence();
+
+    uint64_t before = __rdtscp(&tsc_aux);
+    _mm_lfence();
+    *probe_addr;
+    _mm_mfence();
+    uint64_t after = __rdtscp(&tsc_aux);
+
+    //much slower accesses are caused by interrupts rather than REF (see RefreshTimer::wait_for_refresh)
+    uint64_t timing = after - before;
+    if(timing >= threshold && timing < threshold * 3) {
+      return after;
+    }
+    if(after >= deadline) {
+      return 0;
+    }
+  }
+  return 0;
+}
+
+void RefPhaseTracker::track() {
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset)) {
+    printf("unable to pin the REF tracker to cpu %d.\n", cpu);
+  }
+
+  uint32_t tsc_aux;
+  while(!stopping) {
+    //probe continuously until the period can be estimated; missed edges double a distance, hence the median.
+    std::vector<uint64_t> distances;
+    uint64_t last = 0;
+    while(!stopping && distances.size() < BOOTSTRAP_EDGES) {
+      uint64_t edge = probe_until(UINT64_MAX);
+      if(edge == 0) {
+        return;
+      }
+      if(last != 0) {
+        distances.push_back(edge - last);
+      }
+      last = edge;
+    }
+    if(stopping) {
+      return;
+    }
+    std::nth_element(distances.begin(), distances.begin() + distances.size() / 2, distances.end());
+    uint64_t period = distances[distances.size() / 2];
+    uint64_t next = last + period;
+    prediction.publish(next, period);
+    locked.store(true, std::memory_order_release);
+
+    size_t misses = 0;
+    while(!stopping && misses < MAX_CONSECUTIVE_MISSES) {
+      uint64_t window = std::max<uint64_t>(period / WINDOW_DIVISOR, MIN_WINDOW);
+      //stay off the DRAM until shortly before the predicted edge
+      while(__rdtscp(&tsc_aux) < next - window && !stopping.load(std::memory_order_relaxed)) {
+        _mm_pause();
+      }
+
+      uint64_t edge = probe_until(next + window);
+      if(edge == 0) {
+        if(stopping) {
+          return;
+        }
+        missed++;
+        misses++;
+        next += period;
+        prediction.publish(next, period);
+        continue;
+      }
+      misses = 0;
+      edges++;
+
+      uint64_t error = edge > next ? edge - next : next - edge;
+      sum_abs_error += error;
+      num_errors++;
+      if(error > max_abs_error) {
+        max_abs_error = error;
+      }
+
+      //follow the drift of the period, the distance to the last observed edge may span missed edges
+      uint64_t n = std::max<uint64_t>(1, (edge - last + period / 2) / period);
+      int64_t measured = (edge - last) / n;
+      period += (measured - (int64_t) period) / PERIOD_SMOOTHING;
+      last = edge;
+      next = edge + period;
+      prediction.publish(next, period);
+    }
+    if(stopping) {
+      return;
+    }
+
+    //the hammering threads keep extrapolating the last prediction until the tracker is locked again
+    printf("[WARN] the REF tracker missed %lu edges in a row, estimating the period again.\n", misses);
+    locked.store(false, std::memory_order_release);
+  }
+}
@@ -7,59 +7,101 @@
 #include <vector>
 #include <math.h>
 #define PEAK_DECISION_MULTIPLIER 1.05
-
-RefreshTimer::RefreshTimer(volatile char *measurement_addr) : measurement_addr(measurement_addr) {
+//the relative deviation of the REF threshold that is considered drift
+#define DRIFT_TOLERANCE 0.1
+//the number of samples of each round of reanalyze() and the warmup before it
+#define ANALYSIS_SAMPLES 400000
+#define WARMUP_SAMPLES 100000
+//samples slower than OUTLIER_FACTOR times the median were interrupted rather than delayed by REF
+#define OUTLIER_FACTOR 4
+//only used to find the median, slower samples are outliers anyway
+#define HISTOGRAM_MAX_VALUE 4096
+
+RefreshTimer::RefreshTimer(volatile char *measurement_addr) 
+  : measurement_addr(measurement_addr), 
+    timings(ANALYSIS_SAMPLES), 
+    timestamps(ANALYSIS_SAMPLES), 
+    scratch(ANALYSIS_SAMPLES), 
+    peak_timings(ANALYSIS_SAMPLES), 
+    peak_timestamps(ANALYSIS_SAMPLES), 
+    histogram(HISTOGRAM_MAX_VALUE) {
   refresh_threshold = reanalyze();
 }
 
-double_t RefreshTimer::get_average(std::vector<uint64_t> &measurements) {
-  double_t sum = 0;
-  for(auto measurement : measurements) {
-    sum += measurement;
-  }
-  return sum / measurements.size();
-}
-
-uint64_t RefreshTimer::get_median(std::vector<uint64_t> &measurements) {
-  std::vector<uint64_t> med(measurements);
-  uint64_t mid = med.size() / 2;
-  std::nth_element(med.begin(), med.begin() + measurements.size() / 2, med.end());
-  //this median will not return correct results if measurements contains an even number of elements
-  //however, we expect these differences to be so small that it doesn't really have an impact on the result.
-  return med[mid];
+RefreshTimer::RefreshTimer(volatile char *measurement_addr, uint64_t refresh_threshold, uint64_t cycles_per_refresh) 
+  : measurement_addr(measurement_addr), 
+    refresh_threshold(refresh_threshold), 
+    cycles_per_refresh(cycles_per_refresh),
+    timings(ANALYSIS_SAMPLES), 
+    timestamps(ANALYSIS_SAMPLES), 
+    scratch(ANALYSIS_SAMPLES), 
+    peak_timings(ANALYSIS_SAMPLES), 
+    peak_timestamps(ANALYSIS_SAMPLES), 
+    histogram(HISTOGRAM_MAX_VALUE) {
 }
 
-std::vector<measurement> RefreshTimer::get_measurements(size_t n) {
-  std::vector<measurement> measurements(n);
+void RefreshTimer::get_measurements(size_t n) {
+  n = std::min(n, timings.capacity());
   volatile char *addr = measurement_addr;
   for(size_t i = 0; i < n; i++) {
-    measurements[i] = measure(addr);
+    auto m = measure(addr);
+    timings[i] = m.timing;
+    timestamps[i] = m.timestamp;
   }
-  return measurements;
+  timings.resize(n);
+  timestamps.resize(n);
 }
 
 uint64_t RefreshTimer::get_refresh_threshold() {
   return refresh_threshold - 120;
 }
 
+uint64_t RefreshTimer::get_raw_refresh_threshold() {
+  return refresh_threshold;
+}
+
 uint64_t RefreshTimer::get_cycles_per_refresh() {
   return cycles_per_refresh;
 }
 
-std::vector<uint64_t> RefreshTimer::extract_timings(std::vector<measurement> &measurements) {
-  std::vector<uint64_t> timings(measurements.size());
-  for(int i = 0; i < measurements.size(); i++) {
-    timings[i] = measurements[i].timing;
+RefreshAnalysis RefreshTimer::analyze(size_t n) {
+  get_measurements(n);
+
+  //reject interrupted samples, they would drag the average up
+  histogram.clear();
+  for(auto timing : timings) {
+    histogram.add(timing);
   }
-  return timings;
-}
+  uint64_t limit = OUTLIER_FACTOR * histogram.quantile(0.5);
+  std::copy(timings.begin(), timings.end(), scratch.begin());
+  scratch.resize(TimingStats::reject_above(scratch.data(), timings.size(), limit));
+  double_t avg = TimingStats::mean(scratch.data(), scratch.size());
+
+  peak_timings.clear();
+  peak_timestamps.clear();
+  for(size_t i = 0; i < timings.size(); i++) {
+    if(timings[i] > avg * PEAK_DECISION_MULTIPLIER && timings[i] <= limit) {
+      peak_timings.push(timings[i]);
+      peak_timestamps.push(timestamps[i]);
+    }
+  }
+  if(peak_timings.size() < 2) {
+    printf("[WARN] found only %lu REF peaks in %lu measurements.\n", peak_timings.size(), timings.size());
+    return { (uint64_t)(avg * PEAK_DECISION_MULTIPLIER), 0, peak_timings.size() };
+  }
+
+  uint64_t peak_median = TimingStats::median(peak_timings.data(), peak_timings.size());
 
-std::vector<uint64_t> RefreshTimer::extract_timestamps(std::vector<measurement> &measurements) {
-  std::vector<uint64_t> timestamps(measurements.size());
-  for(int i = 0; i < measurements.size(); i++) {
-    timestamps[i] = measurements[i].timestamp;
+  //the median distance ignores REFs that were missed or hit two consecutive samples
+  for(size_t i = 1; i < peak_timestamps.size(); i++) {
+    peak_timestamps[i - 1] = peak_timestamps[i] - peak_timestamps[i - 1];
   }
-  return timestamps;
+  uint64_t cycles = TimingStats::median(peak_timestamps.data(), peak_timestamps.size() - 1);
+
+  //the median of the peaks should always be higher than the average across all samples
+  //we select the middle between the average across all samples and the median of all peaks
+  //as our threshold for refresh-induced peaks.
+  return { (uint64_t)(avg + ((peak_median - avg) / 2)), cycles, peak_timings.size() };
 }
 
 uint64_t RefreshTimer::wait_for_refresh(size_t bank) {
@@ -90,37 +132,35 @@ uint64_t RefreshTimer::reanalyze() {
   do {
     previous = threshold;
     //warmup
-    get_measurements(100000);
+    get_measurements(WARMUP_SAMPLES);
     sched_yield();
 
-    std::vector<measurement> measurements = get_measurements(400000);
-    std::vector<uint64_t> timings = extract_timings(measurements);
-    double_t avg = get_average(timings);
-
-    std::vector<measurement> peaks;
-    for(auto measurement : measurements) {
-      if(measurement.timing > avg * PEAK_DECISION_MULTIPLIER) {
-        peaks.push_back(measurement);
-      }
-    }
-    
-    auto peak_timings = extract_timings(peaks);
-    uint64_t peak_median = get_median(peak_timings);
-
-    std::vector<uint64_t> peak_diffs(peaks.size() - 1);
-    for(int j = 1; j < peaks.size(); j++) {
-      peak_diffs.push_back(peaks[j].timestamp - peaks[j - 1].timestamp);
-    }
-
-    cycles_per_refresh = get_average(peak_diffs);
-   
-    //the median of the peaks should always be higher than the average across all samples
-    //we select the middle between the average across all samples and the median of all peaks
-    //as our threshold for refresh-induced peaks.
-    threshold = avg + ((peak_median - avg) / 2);
-    printf("measured threshold to be %lu. %lu cycles per refresh based on %lu peaks\n", threshold, cycles_per_refresh, peaks.size());
+    auto analysis = analyze(ANALYSIS_SAMPLES);
+    threshold = analysis.threshold;
+    cycles_per_refresh = analysis.cycles_per_refresh;
+    printf("measured threshold to be %lu. %lu cycles per refresh based on %lu peaks\n", threshold, cycles_per_refresh, analysis.num_peaks);
     assert(++i < 30);
   } while(fmin(previous, threshold) / (float_t)fmax(previous, threshold) > 0.1);
 
   return threshold;
 }
+
+void RefreshTimer::recalibrate() {
+  refresh_threshold = reanalyze();
+}
+
+bool RefreshTimer::drifted(size_t n) {
+  //a single, short round of the analysis done by reanalyze(): without a warmup and without waiting for the result to settle.
+  auto analysis = analyze(n);
+  if(analysis.num_peaks == 0) {
+    printf("[WARN] no REF peaks in %lu measurements, the REF threshold of %lu has drifted.\n", n, refresh_threshold);
+    return true;
+  }
+
+  double_t deviation = fabs((double_t)analysis.threshold - refresh_threshold) / refresh_threshold;
+  if(deviation > DRIFT_TOLERANCE) {
+    printf("[WARN] measured a REF threshold of %lu instead of %lu (%.1f%% off).\n", analysis.threshold, refresh_threshold, 100 * deviation);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,26 @@
+#include "StreamStore.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+void StreamStore::copy(volatile void *dst, const void *src, size_t len) {
+  auto *d = (char *) dst;
+  const auto *s = (const char *) src;
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 64 <= len; i += 64) {
+    _mm512_stream_si512((__m512i *) (d + i), _mm512_load_si512((const void *) (s + i)));
+  }
+#elif defined(__AVX2__)
+  for (; i + 32 <= len; i += 32) {
+    _mm256_stream_si256((__m256i *) (d + i), _mm256_load_si256((const __m256i *) (s + i)));
+  }
+#else
+  for (; i + 16 <= len; i += 16) {
+    _mm_stream_si128((__m128i *) (d + i), _mm_load_si128((const __m128i *) (s + i)));
+  }
+#endif
+  for (; i < len; i++) {
+    d[i] = s[i];
+  }
+}
@@ -0,0 +1,136 @@
+#include "TimingStats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+void Histogram::clear() {
+  std::fill(bins.begin(), bins.end(), 0);
+  total = 0;
+  rejected = 0;
+}
+
+uint64_t Histogram::quantile(double q) const {
+  auto target = (size_t) std::ceil(q * total);
+  size_t cumulative = 0;
+  for (size_t value = 0; value < bins.size(); value++) {
+    cumulative += bins[value];
+    if (cumulative >= target && cumulative > 0) {
+      return value;
+    }
+  }
+  return bins.size() - 1;
+}
+
+uint64_t Histogram::top(size_t n) const {
+  size_t cumulative = 0;
+  for (size_t value = bins.size(); value-- > 0;) {
+    cumulative += bins[value];
+    if (cumulative >= n) {
+      return value;
+    }
+  }
+  return 0;
+}
+
+// NOTE: The vectorized comparisons are signed, which is fine for TSC deltas (< 2^63).
+
+uint64_t TimingStats::sum(const uint64_t *samples, size_t n) {
+  size_t i = 0;
+  uint64_t total = 0;
+#if defined(__AVX512F__)
+  __m512i acc = _mm512_setzero_si512();
+  for (; i + 8 <= n; i += 8) {
+    acc = _mm512_add_epi64(acc, _mm512_loadu_si512((const void *) (samples + i)));
+  }
+  total = _mm512_reduce_add_epi64(acc);
+#elif defined(__AVX2__)
+  // two accumulators to hide the latency of the additions
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256((const __m256i *) (samples + i)));
+    acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256((const __m256i *) (samples + i + 4)));
+  }
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256((__m256i *) lanes, _mm256_add_epi64(acc0, acc1));
+  total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+  for (; i < n; i++) {
+    total += samples[i];
+  }
+  return total;
+}
+
+uint64_t TimingStats::max(const uint64_t *samples, size_t n) {
+  size_t i = 0;
+  uint64_t result = 0;
+#if defined(__AVX512F__)
+  __m512i acc = _mm512_setzero_si512();
+  for (; i + 8 <= n; i += 8) {
+    acc = _mm512_max_epu64(acc, _mm512_loadu_si512((const void *) (samples + i)));
+  }
+  result = _mm512_reduce_max_epu64(acc);
+#elif defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 4 <= n; i += 4) {
+    __m256i values = _mm256_loadu_si256((const __m256i *) (samples + i));
+    acc = _mm256_blendv_epi8(acc, values, _mm256_cmpgt_epi64(values, acc));
+  }
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256((__m256i *) lanes, acc);
+  result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+  for (; i < n; i++) {
+    result = std::max(result, samples[i]);
+  }
+  return result;
+}
+
+size_t TimingStats::count_above(const uint64_t *samples, size_t n, uint64_t threshold) {
+  size_t i = 0;
+  size_t count = 0;
+#if defined(__AVX512F__)
+  const __m512i limit = _mm512_set1_epi64((int64_t) threshold);
+  for (; i + 8 <= n; i += 8) {
+    count += __builtin_popcount(_mm512_cmpgt_epu64_mask(_mm512_loadu_si512((const void *) (samples + i)), limit));
+  }
+#elif defined(__AVX2__)
+  const __m256i limit = _mm256_set1_epi64x((int64_t) threshold);
+  // each lane of a comparison is -1 if the sample is above the threshold
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm256_sub_epi64(acc, _mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i *) (samples + i)), limit));
+  }
+  alignas(32) uint64_t lanes[4];
+  _mm256_store_si256((__m256i *) lanes, acc);
+  count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+  for (; i < n; i++) {
+    count += samples[i] > threshold;
+  }
+  return count;
+}
+
+uint64_t TimingStats::quantile(uint64_t *samples, size_t n, double q) {
+  auto idx = std::min(n - 1, (size_t) (q * (n - 1) + 0.5));
+  std::nth_element(samples, samples + idx, samples + n);
+  return samples[idx];
+}
+
+size_t TimingStats::reject_above(uint64_t *samples, size_t n, uint64_t limit) {
+  return std::remove_if(samples, samples + n, [limit](uint64_t sample) { return sample > limit; }) - samples;
+}
+
+double TimingStats::upper_semideviation(const uint64_t *samples, size_t n, double mean) {
+  if (n == 0) {
+    return 0;
+  }
+  double var = 0;
+  for (size_t i = 0; i < n; i++) {
+    double diff = (double) samples[i] - mean;
+    var += diff > 0 ? diff * diff : 0;
+  }
+  return std::sqrt(var / n);
+}
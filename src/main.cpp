@@ -1,11 +1,23 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
+#include "CalibrationProfile.hpp"
+#include "CodeJitter.hpp"
+#include "CpuTopology.hpp"
 #include "DRAMAddr.hpp"
 #include "DRAMConfig.hpp"
+#include "DramAnalyzer.hpp"
 #include "Enums.hpp"
 #include "FuzzingParameterSet.hpp"
 #include "GlobalDefines.hpp"
@@ -14,8 +26,10 @@
 #include "Memory.hpp"
 #include "PatternAddressMapper.hpp"
 #include "PatternBuilder.hpp"
+#include "RefreshTimer.hpp"
 #include "SimplePatternBuilder.hpp"
 #include <sys/resource.h>
+#include <unistd.h>
 
 SCHEDULING_POLICY find_policy(std::string policy) {
   if("pair" == policy) {
@@ -70,6 +84,36 @@ FENCING_STRATEGY find_fencing_strategy(std::string strategy) {
   return FENCING_STRATEGY::EARLIEST_POSSIBLE;
 }
 
+PLACEMENT_POLICY find_placement_policy(std::string policy) {
+  if("legacy" == policy) {
+    return PLACEMENT_POLICY::LEGACY;
+  } else if("smt" == policy) {
+    return PLACEMENT_POLICY::SMT_PAIRS;
+  } else if("ccx" == policy) {
+    return PLACEMENT_POLICY::SAME_CCX;
+  } else if("spread" == policy) {
+    return PLACEMENT_POLICY::SPREAD;
+  }
+
+  return PLACEMENT_POLICY::PHYSICAL_CORES;
+}
+
+JIT_EMITTER find_jit_emitter(std::string emitter) {
+  if("compact" == emitter) {
+    return JIT_EMITTER::COMPACT;
+  }
+
+  return JIT_EMITTER::UNROLLED;
+}
+
+SYNC_MODE find_sync_mode(std::string mode) {
+  if("predicted" == mode) {
+    return SYNC_MODE::PREDICTED;
+  }
+
+  return SYNC_MODE::PROBE;
+}
+
 bool string_to_bool(std::string str) {
   return "true" == str;
 }
@@ -95,10 +139,22 @@ void print_help() {
   printf("%-40s: column randomization style (all, aggressor, none).\n", "-rs, --randomization-style");
   printf("%-40s: compensate for the difference in access counts when interleaving.\n", "--compensate");
   printf("%-40s: number of aggressors to use when building a simple pattern.\n", "-sa, --simple-num-aggs <aggs>");
+  printf("%-40s: how hammering functions are jitted (unrolled, compact).\n", "--jit-emitter <type>");
+  printf("%-40s: compare ACTs/us and code size of the JIT emitters and exit.\n", "--benchmark-jit");
+  printf("%-40s: compare the address translations per second of the translation methods and exit.\n", "--benchmark-translation");
+  printf("%-40s: how hammering functions synchronize with REF (probe, predicted by a tracker on a spare core).\n", "--sync <mode>");
+  printf("%-40s: size patterns by the measured ACTs per tREFI of their bank instead of a random number.\n", "--measured-acts");
+  printf("%-40s: prepare the next fuzzing round on a separate core while hammering.\n", "--pipeline");
+  printf("%-40s: where hammering threads run (physical, smt, ccx, spread, legacy).\n", "--placement <policy>");
+  printf("%-40s: number of superpages to allocate and spread the patterns over.\n", "--mappings <mappings>");
+  printf("%-40s: run each line (\"<name> <flags>\") of the file with one allocation.\n", "--matrix <file>");
+  printf("%-40s: where the outputs of the matrix cells are stored.\n", "--matrix-dir <dir>");
+  printf("%-40s: where the calibration of this machine is stored (default: %s).\n", "--profile <file>", CalibrationProfile::DEFAULT_PATH);
+  printf("%-40s: calibrate again even if a profile for this machine is stored.\n", "--recalibrate");
 }
 
-Args parse_args(int argc, char* argv[]) {
-  Args args;
+// parses the flags on top of the given arguments
+Args parse_args(int argc, char* argv[], Args args = Args()) {
   for(int i = 1; i < argc; i++) {
     if((strcmp("-r", argv[i]) == 0 || strcmp("--runtime", argv[i]) == 0) && i + 1 < argc) {
       args.runtime_limit = atoi(argv[i + 1]);
@@ -179,13 +235,44 @@ Args parse_args(int argc, char* argv[]) {
     } else if(strcmp("--flushing-strategy", argv[i]) == 0 && i + 1 < argc) {
       args.flushing_strategy = find_flushing_strategy(std::string(argv[i + 1]));
       i++;
+    } else if(strcmp("--jit-emitter", argv[i]) == 0 && i + 1 < argc) {
+      args.jit_emitter = find_jit_emitter(std::string(argv[i + 1]));
+      i++;
+    } else if(strcmp("--sync", argv[i]) == 0 && i + 1 < argc) {
+      args.sync_mode = find_sync_mode(std::string(argv[i + 1]));
+      i++;
+    } else if(strcmp("--measured-acts", argv[i]) == 0) {
+      args.measured_acts = true;
+    } else if(strcmp("--benchmark-jit", argv[i]) == 0) {
+      args.benchmark_jit = true;
+    } else if(strcmp("--benchmark-translation", argv[i]) == 0) {
+      args.benchmark_translation = true;
+    } else if(strcmp("--pipeline", argv[i]) == 0) {
+      args.pipeline = true;
+    } else if(strcmp("--matrix", argv[i]) == 0 && i + 1 < argc) {
+      args.matrix = argv[i + 1];
+      i++;
+    } else if(strcmp("--matrix-dir", argv[i]) == 0 && i + 1 < argc) {
+      args.matrix_dir = argv[i + 1];
+      i++;
+    } else if(strcmp("--profile", argv[i]) == 0 && i + 1 < argc) {
+      args.profile = argv[i + 1];
+      i++;
+    } else if(strcmp("--recalibrate", argv[i]) == 0) {
+      args.recalibrate = true;
+    } else if(strcmp("--mappings", argv[i]) == 0 && i + 1 < argc) {
+      args.mappings = std::max(1L, atol(argv[i + 1]));
+      i++;
+    } else if(strcmp("--placement", argv[i]) == 0 && i + 1 < argc) {
+      args.placement = find_placement_policy(std::string(argv[i + 1]));
+      i++;
     } else if(strcmp("-h", argv[i]) == 0 || strcmp("--help", argv[i]) == 0) {
       print_help();
       exit(0);
     } else if(strcmp("--thread", argv[i]) == 0 && i + 1 < argc) {
       args.thread_start_id = atol(argv[i + 1]);
       i++;
-    } else if(strcmp("-rs", argv[i]) == 0 || strcmp("--randomization-style", argv[i]) && i + 1 < argc) {
+    } else if((strcmp("-rs", argv[i]) == 0 || strcmp("--randomization-style", argv[i]) == 0) && i + 1 < argc) {
       args.randomization_style = find_randomization_style(std::string(argv[i + 1]));
       i++;
     } else {
@@ -198,32 +285,132 @@ Args parse_args(int argc, char* argv[]) {
   return args;
 }
 
-int main(int argc, char* argv[]) {
-  Logger::initialize();
-  // give this process the highest CPU priority so it can hammer with less interruptions
-  int ret = setpriority(PRIO_PROCESS, 0, -20);
-  if (ret!=0) printf("Instruction setpriority failed.\n");
-  
-  DRAMConfig::select_config(Microarchitecture::AMD_ZEN_3, 1, 4, 4, false);
+// hammers patterns of increasing length on bank 0 with each JIT emitter and reports the achieved ACT rate (from the
+// ACT count and TSC delta recorded by the jitted function) and the size of the generated code.
+void benchmark_jit(Args &args) {
+  RefreshTimer timer((volatile char *)DRAMAddr(0, 0, 0).to_virt());
+  DRAMConfig::get().set_sync_ref_threshold(timer.get_refresh_threshold());
 
-  Args args = parse_args(argc, argv);
+  auto tsc_start = RefreshTimer::current_timestamp();
+  auto clock_start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto tsc_end = RefreshTimer::current_timestamp();
+  auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - clock_start).count();
+  double tsc_per_us = (double)(tsc_end - tsc_start) / elapsed_us;
+
+  const int total_acts = 2000000;
+  const size_t num_rows = 32;
+  const size_t repetitions = 5;
+  FuzzingParameterSet params;
 
+  printf("%-10s %-10s %12s %12s\n", "accesses", "emitter", "code bytes", "ACTs/us");
+  for(size_t accesses : {32, 256, 2048, 8192}) {
+    PatternIR pattern;
+    for(size_t i = 0; i < accesses; i++) {
+      pattern.access((volatile char *)DRAMAddr(0, 100 + 2 * (i % num_rows), 0).to_virt());
+    }
 
+    for(auto emitter : {JIT_EMITTER::UNROLLED, JIT_EMITTER::COMPACT}) {
+      CodeJitter jitter;
+      jitter.emitter = emitter;
+      jitter.jit_strict(args.flushing_strategy, args.fencing_strategy, pattern, args.fence_type, total_acts);
 
-  Memory alloc(true);
-  if(args.seed > 0) {
-    alloc.set_seed(args.seed);
-    HammerSuite::set_seed(args.seed);
-    FuzzingParameterSet::set_seed(args.seed);
-    SimplePatternBuilder::set_seed(args.seed);
-    PatternBuilder::set_seed(args.seed);
-    PatternAddressMapper::set_seed(args.seed);
+      double best = 0;
+      for(size_t rep = 0; rep < repetitions; rep++) {
+        HammeringData data;
+        jitter.hammer_pattern(params, false, false, &data);
+        if(data.tsc_delta > 0) {
+          best = std::max(best, data.total_acts / (data.tsc_delta / tsc_per_us));
+        }
+      }
+      printf("%-10lu %-10s %12lu %12.2f\n", accesses, to_string(emitter).c_str(), jitter.get_code_size(), best);
+      jitter.cleanup();
+    }
   }
-  printf("creating allocation...\n");
-  alloc.allocate_memory(DRAMConfig::get().memory_size());
-  printf("allocated %lu bytes of memory.\n", alloc.get_allocation_size());
-  DRAMAddr::initialize_mapping(0, alloc.get_starting_address());
+}
+
+// translates random addresses of mapping 0 with each translation method (physical -> DRAM with DRAMAddr(void*) and back
+// with to_virt()) and reports the translations per second; the results are checked against the parity method.
+void benchmark_translation(Memory &alloc) {
+  const size_t num_addrs = 1 << 16;
+  const size_t repetitions = 32;
+  auto &config = DRAMConfig::get();
+  //the addresses are only translated, not accessed, so they just need the MSBs of mapping 0
+  auto base_msb = (size_t)alloc.get_mapping_address(0) & ~(config.memory_size() - 1);
+
+  std::mt19937_64 gen(1);
+  std::vector<size_t> addrs(num_addrs);
+  for(auto &addr : addrs) {
+    addr = base_msb | (gen() % config.memory_size());
+  }
+
+  //the reference results are computed with the parity method
+  std::vector<DRAMAddr> reference;
+  config.set_translation_method(TranslationMethod::PARITY);
+  reference.reserve(num_addrs);
+  for(auto addr : addrs) {
+    reference.emplace_back((void *)addr);
+  }
+
+  printf("%-14s %18s %18s\n", "method", "phys->DRAM /s", "DRAM->phys /s");
+  for(auto method : {TranslationMethod::PARITY, TranslationMethod::LOOKUP_TABLE, TranslationMethod::PEXT}) {
+    if(!config.set_translation_method(method)) {
+      printf("%-14s %18s %18s\n", to_string(method), "n/a", "n/a");
+      continue;
+    }
+
+    size_t mismatches = 0;
+    std::vector<DRAMAddr> dram_addrs;
+    dram_addrs.reserve(num_addrs);
+    auto begin = std::chrono::steady_clock::now();
+    for(size_t rep = 0; rep < repetitions; rep++) {
+      dram_addrs.clear();
+      for(auto addr : addrs) {
+        dram_addrs.emplace_back((void *)addr);
+      }
+    }
+    double to_dram_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    //the sum of the translated addresses keeps the translations from being optimized out and is checked below
+    size_t checksum = 0;
+    begin = std::chrono::steady_clock::now();
+    for(size_t rep = 0; rep < repetitions; rep++) {
+      for(auto &dram_addr : dram_addrs) {
+        checksum += (size_t)dram_addr.to_virt();
+      }
+    }
+    double to_phys_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    size_t expected_checksum = 0;
+    for(size_t i = 0; i < num_addrs; i++) {
+      expected_checksum += addrs[i] * repetitions;
+      if(dram_addrs[i].bank != reference[i].bank || dram_addrs[i].row != reference[i].row ||
+         dram_addrs[i].col != reference[i].col || (size_t)dram_addrs[i].to_virt() != addrs[i]) {
+        mismatches++;
+      }
+    }
+    printf("%-14s %18.0f %18.0f\n", to_string(method), num_addrs * repetitions / to_dram_s,
+           num_addrs * repetitions / to_phys_s);
+    if(mismatches > 0) {
+      printf("[ERROR] %lu of %lu addresses were translated differently than with the parity method.\n", mismatches, num_addrs);
+    }
+    if(checksum != expected_checksum) {
+      printf("[ERROR] the addresses translated back while timing do not match the original addresses.\n");
+    }
+  }
+
+  config.select_fastest_translation();
+}
 
+void seed_generators(uint64_t seed) {
+  HammerSuite::set_seed(seed);
+  FuzzingParameterSet::set_seed(seed);
+  SimplePatternBuilder::set_seed(seed);
+  PatternBuilder::set_seed(seed);
+  PatternAddressMapper::set_seed(seed);
+}
+
+void print_args(Args &args) {
   printf("initialized runtime parameter to %lu.\n", args.runtime_limit);
   printf("initialized location parameter to %hu.\n", args.locations);
   printf("initialized threads parameter to %hu\n", args.threads);
@@ -232,29 +419,188 @@ int main(int argc, char* argv[]) {
   printf("initialized simple pattern mode for first thread to %b\n", args.simple_patterns_first_thread);
   printf("initialized simple pattern mode for other threads to %b\n", args.simple_patterns_other_threads);
   printf("initialized fencing strategy to %s\n", to_string(args.fence_type).c_str());
+  printf("initialized REF sync mode to %s\n", to_string(args.sync_mode).c_str());
+  if(args.measured_acts) {
+    printf("patterns are sized by the measured ACTs per tREFI of their bank.\n");
+  }
+  printf("initialized placement policy to %s on %s: cpus", to_string(args.placement).c_str(),
+         CpuTopology::get().to_string().c_str());
+  for(auto cpu : CpuTopology::get().place(args.placement, args.threads, args.thread_start_id)) {
+    printf(" %d", cpu);
+  }
+  printf("\n");
   if(args.randomization_style != ColumnRandomizationStyle::NONE) {
     printf("columns will be randomized with type: %s\n", 
            args.randomization_style == ColumnRandomizationStyle::PER_AGGRESSOR ? "PER_AGGRESSOR" : "PER_ACCESS");
   }
-  HammerSuite *suite;
   if(args.interleaved) {
     printf("running in interleaved mode, just a single thread will be used.\n");
   }
   if(args.seed > 0) {
     printf("initialized seed to %lu\n", args.seed);
   }
-  suite = new HammerSuite(alloc);
-  
   if(args.test_effective_patterns_random) {
     printf("will test effective patterns in multiple fuzzing runs with random additional patterns after we are finished.\n");
   }
   if(args.test_effective_patterns_combined) {
     printf("will test effective patterns in multiple fuzzing runs using all effective patterns after we are finished.\n");
   }
+}
+
+void run(HammerSuite &suite, Memory &alloc, Args &args) {
+  print_args(args);
   printf("starting hammering run!\n");
-  std::vector<FuzzReport> reports = suite->auto_fuzz(args);
+  std::vector<FuzzReport> reports = suite.auto_fuzz(args);
   size_t full_check = alloc.check_memory(alloc.get_starting_address(), alloc.get_starting_address() + alloc.get_allocation_size());
   printf("full check found %lu flips.\n", full_check);
+}
+
+struct MatrixCell {
+  std::string name;
+  std::vector<std::string> flags;
+  Args args;
+};
+
+// runs every cell of the experiment matrix in its own subdirectory of args.matrix_dir (which takes the logfile, the
+// csv files and main.log, the standard output of the cell). Each line of the matrix file is "<name> <flags>"; the flags
+// are applied on top of the command line, empty lines and lines starting with # are skipped. In contrast to launching
+// the binary for every cell, the allocation and the REF calibration are shared by all cells.
+void run_matrix(HammerSuite &suite, Memory &alloc, Args &args) {
+  std::ifstream file(args.matrix);
+  if(!file.is_open()) {
+    printf("could not open matrix file %s.\n", args.matrix.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<MatrixCell> cells;
+  std::string line;
+  while(std::getline(file, line)) {
+    std::istringstream tokens(line);
+    MatrixCell cell;
+    if(!(tokens >> cell.name) || cell.name[0] == '#') {
+      continue;
+    }
+    std::string flag;
+    while(tokens >> flag) {
+      cell.flags.push_back(flag);
+    }
+
+    //parse all cells up front, so an invalid cell does not abort the matrix half way.
+    std::vector<char *> cell_argv { (char *)"matrix" };
+    for(auto &f : cell.flags) {
+      cell_argv.push_back(f.data());
+    }
+    cell.args = parse_args(cell_argv.size(), cell_argv.data(), args);
+    cell.args.matrix.clear();
+    if(cell.args.mappings != args.mappings) {
+      printf("cell %s cannot change the number of mappings, using %lu.\n", cell.name.c_str(), args.mappings);
+      cell.args.mappings = args.mappings;
+    }
+    cells.push_back(std::move(cell));
+  }
+
+  auto cwd = std::filesystem::current_path();
+  auto matrix_dir = cwd / args.matrix_dir;
+  for(auto &cell : cells) {
+    auto dir = matrix_dir / cell.name;
+    if(std::filesystem::exists(dir) && !std::filesystem::is_empty(dir)) {
+      printf("%s contains files. aborting.\n", dir.c_str());
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  for(size_t c = 0; c < cells.size(); c++) {
+    auto &cell = cells[c];
+    auto &cell_args = cell.args;
+
+    auto dir = matrix_dir / cell.name;
+    std::filesystem::create_directories(dir);
+    std::ofstream flags(dir / "flags.txt");
+    for(auto &flag : cell.flags) {
+      flags << flag << " ";
+    }
+    flags << "\n";
+    flags.close();
+
+    printf("[%lu/%lu] running %s for %lu seconds.\n", c + 1, cells.size(), cell.name.c_str(), cell_args.runtime_limit);
+    fflush(stdout);
+
+    Logger::close();
+    std::filesystem::current_path(dir);
+    Logger::initialize();
+    int saved_stdout = dup(STDOUT_FILENO);
+    int main_log = open("main.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    dup2(main_log, STDOUT_FILENO);
+    close(main_log);
+
+    //every cell starts from the same state, as if the binary was launched for it.
+    if(cell_args.seed > 0) {
+      seed_generators(cell_args.seed);
+    }
+    PatternAddressMapper::set_bank_counter(0);
+    PatternAddressMapper::mapping_counter = 0;
+    run(suite, alloc, cell_args);
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    Logger::close();
+    std::filesystem::current_path(cwd);
+    Logger::initialize();
+  }
+  printf("finished %lu matrix cells.\n", cells.size());
+}
+
+int main(int argc, char* argv[]) {
+  Logger::initialize();
+  // give this process the highest CPU priority so it can hammer with less interruptions
+  int ret = setpriority(PRIO_PROCESS, 0, -20);
+  if (ret!=0) printf("Instruction setpriority failed.\n");
+  
+  DRAMConfig::select_config(Microarchitecture::AMD_ZEN_3, 1, 4, 4, false);
+
+  Args args = parse_args(argc, argv);
+
+
+
+  Memory alloc(true);
+  if(args.seed > 0) {
+    alloc.set_seed(args.seed);
+    seed_generators(args.seed);
+  }
+  printf("creating allocation...\n");
+  alloc.allocate_memory(DRAMConfig::get().memory_size(), args.mappings);
+  printf("allocated %lu bytes of memory in %lu mappings.\n", alloc.get_allocation_size(), alloc.get_num_mappings());
+  for(size_t i = 0; i < alloc.get_num_mappings(); i++) {
+    DRAMAddr::initialize_mapping(i, alloc.get_mapping_address(i));
+  }
+  if(args.benchmark_translation) {
+    benchmark_translation(alloc);
+    Logger::close();
+    return 0;
+  }
+  CalibrationProfile profile = CalibrationProfile::load_or_measure(args.profile, alloc.get_mapping_address(0), args.recalibrate);
+  if(alloc.get_num_mappings() > 1) {
+    //the physical address bits above a mapping permute its banks, so find the bank of mapping 0 that each bank corresponds to.
+    DramAnalyzer analyzer(alloc.get_mapping_address(0));
+    analyzer.set_threshold(profile.bank_conflict_threshold);
+    for(size_t i = 1; i < alloc.get_num_mappings(); i++) {
+      DRAMAddr::initialize_bank_translation(0, i, analyzer.get_corresponding_banks_for_mapping(i, alloc.get_mapping_address(i)));
+    }
+  }
+
+  if(args.benchmark_jit) {
+    benchmark_jit(args);
+    Logger::close();
+    return 0;
+  }
+
+  HammerSuite suite(alloc);
+  suite.calibrate(profile);
+  if(!args.matrix.empty()) {
+    run_matrix(suite, alloc, args);
+  } else {
+    run(suite, alloc, args);
+  }
   Logger::close();
-  delete suite;
 }